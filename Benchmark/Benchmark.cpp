@@ -0,0 +1,84 @@
+// Benchmark.cpp : Renders a synthetic winmd with each member layout and reports how long each run takes, with the
+// emitters specialized per layout and with the baseline that checks the layout flags in every member loop.
+// Usage: Benchmark.exe [namespaces] [typesPerNamespace] [membersPerType] [iterations]
+//
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../winmd2markdown/Program.h"
+#include "../winmd2markdown/WinmdWriter.h"
+
+using namespace std;
+
+// Switches a Program to the baseline emitters, which read the layout flags in every member loop
+struct layout_benchmark
+{
+  static void UseRuntimeLayouts(Program& program) { program.runtimeLayouts = true; }
+};
+
+// Pages are rendered to memory so that the numbers measure the emitters rather than the file system
+std::shared_ptr<std::ostream> GetOutputStream(const std::filesystem::path&)
+{
+  return make_shared<ostringstream>();
+}
+
+int main(int argc, char** argv)
+{
+  try {
+    corpus_options corpus{ 4, 500, 40, true };
+    size_t iterations = 5;
+    if (argc > 1) corpus.namespaces = stoul(argv[1]);
+    if (argc > 2) corpus.typesPerNamespace = stoul(argv[2]);
+    if (argc > 3) corpus.membersPerType = stoul(argv[3]);
+    if (argc > 4) iterations = stoul(argv[4]);
+
+    const auto workDir = filesystem::temp_directory_path() / "winmd2md-benchmark";
+    filesystem::create_directories(workDir);
+    const auto winmd = (workDir / "Synthetic.winmd").u8string();
+    WriteSyntheticCorpus(winmd, corpus);
+    cout << "Corpus: " << corpus.namespaces << " namespaces x " << corpus.typesPerNamespace << " types x "
+      << corpus.membersPerType << " members\n";
+
+    const vector<pair<string, vector<string>>> layouts = {
+      { "sections", {} },
+      { "propsAsTable", { "/propsAsTable" } },
+      { "fieldsAsTable", { "/fieldsAsTable" } },
+      { "propsAsTable fieldsAsTable", { "/propsAsTable", "/fieldsAsTable" } },
+    };
+    cout << setw(28) << left << "layout" << setw(14) << right << "runtime" << setw(14) << "specialized" << setw(10) << "speedup" << "\n";
+    for (const auto& [name, switches] : layouts) {
+      auto args = switches;
+      args.insert(args.end(), { "/outputDirectory", (workDir / "out").u8string(), winmd });
+
+      auto bestOf = [&](bool runtimeLayouts) {
+        double best = numeric_limits<double>::max();
+        for (size_t i = 0; i < iterations; i++) {
+          Program program;
+          if (runtimeLayouts) layout_benchmark::UseRuntimeLayouts(program);
+          const auto start = chrono::steady_clock::now();
+          program.Process(args);
+          best = min(best, chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+        }
+        return best;
+      };
+      const auto baseline = bestOf(true);
+      const auto specialized = bestOf(false);
+      cout << setw(28) << left << name << right << fixed << setprecision(1) << setw(11) << baseline << " ms" << setw(11) << specialized << " ms"
+        << setprecision(2) << setw(9) << baseline / specialized << "x\n";
+    }
+    cout << "best of " << iterations << " runs each\n";
+    return 0;
+  }
+  catch (const exception& e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+}
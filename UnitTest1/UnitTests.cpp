@@ -6,7 +6,12 @@
 #include <unordered_map>
 
 #include "CppUnitTest.h"
+#include "../winmd2markdown/Archive.h"
+#include "../winmd2markdown/Bundle.h"
+#include "../winmd2markdown/MappedFile.h"
 #include "../winmd2markdown/Program.h"
+#include "../winmd2markdown/TextScan.h"
+#include "../winmd2markdown/WinmdWriter.h"
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 using namespace std;
@@ -127,6 +132,489 @@ f() doc_string
 )");
 
 	}
+
+	TEST_METHOD(SyntheticCorpus) {
+		WriteSyntheticCorpus("Synthetic.winmd", { 1, 10, 4, true });
+		winmd::reader::cache synthetic(std::vector<std::string>{ "Synthetic.winmd" });
+		const auto& ns = synthetic.namespaces().at("Synthetic.Namespace0");
+		assert(ns.interfaces.size() == 2);
+		assert(ns.classes.size() == 2);
+		assert(ns.enums.size() == 2);
+		assert(ns.structs.size() == 2);
+		assert(ns.delegates.size() == 2);
+
+		const auto type1 = synthetic.find("Synthetic.Namespace0", "Type1");
+		assert(std::distance(type1.PropertyList().first, type1.PropertyList().second) == 2);
+		assert(std::distance(type1.EventList().first, type1.EventList().second) == 1);
+		bool hasDocString = false;
+		for (const auto& ca : type1.CustomAttribute()) {
+			hasDocString |= ca.TypeNamespaceAndName().second == "DocStringAttribute";
+		}
+		assert(hasDocString);
+	}
+
+	TEST_METHOD(UnescapeDocText) {
+		assert(!::UnescapeDocText("no escapes, see https://github.com", true).is_copy());
+		assert(std::string_view(::UnescapeDocText("a\\nb\\r\\nc\r\nd", true)) == "a\nb\nc\nd");
+		assert(std::string_view(::UnescapeDocText("x\\ry /-/ z", true)) == "x\ry // z");
+		assert(std::string_view(::UnescapeDocText("8080\\n/-/", false)) == "8080\n/-/");
+	}
+
+	TEST_METHOD(TextScan) {
+		const std::string prose = std::string(70, 'x') + "`code` see @Namespace.Type_1.Member. and <br/>";
+		assert(FindFirstOf(prose, 0, '@', '<') == prose.find('@'));
+		assert(FindFirstOf(prose, 0, '<', '`') == 70);
+		assert(FindFirstOf(prose, prose.length(), '@', '@') == prose.length());
+		const auto start = prose.find('@') + 1;
+		assert(SkipIdentifierChars(prose, start) == prose.find(' ', start));
+		assert(SkipIdentifierChars(std::string(40, 'a'), 3) == 40);
+	}
+
+	TEST_METHOD(RenderMember) {
+		const auto render = program.SelectRenderer();
+		assert((program.*render)("Test.Class1.MyProperty", false) == R"(### MyProperty
+ int `MyProperty`
+
+**Default value**: `MyProperty value`
+
+MyProperty doc_string
+
+)");
+		const auto xml = (program.*render)("Test.Class1.MyProperty", true);
+		assert(xml.find(R"(<member name="P:Test.Class1.MyProperty">)") != std::string::npos);
+	}
+
+	TEST_METHOD(Bundle) {
+		{
+			bundle_writer bundle("docs.bundle");
+			*bundle.Open("B-api-windows.md", false) << "page B";
+			*bundle.Open("A-api-windows.md", false) << "page A";
+			bundle.Flush();
+			// appended after being flushed, so it has to be moved in one piece when the bundle is closed
+			*bundle.Open("A-api-windows.md", true) << " referenced by";
+			bundle.Close();
+		}
+		{
+			// a run that fails before closing its bundle doesn't leave one behind
+			bundle_writer partial("partial.bundle");
+			*partial.Open("A-api-windows.md", false) << "page A";
+			partial.Flush();
+		}
+		assert(!std::filesystem::exists("partial.bundle"));
+		bundle_reader reader("docs.bundle");
+		assert(reader.Entries().size() == 2);
+		assert(reader.Find("A-api-windows.md") == std::string_view("page A referenced by"));
+		assert(reader.Find("B-api-windows.md") == std::string_view("page B"));
+		assert(!reader.Find("index-api-windows.md"));
+	}
+
+	TEST_METHOD(Deflate) {
+		std::string page;
+		for (int i = 0; i < 200; i++) {
+			page += "### Property" + std::to_string(i) + "\n int `Property" + std::to_string(i) + "`\n\n";
+		}
+		const auto gz = ::Gzip(page);
+		assert(gz.size() < page.size() / 3);
+		assert(::Gzip(page) == gz); // archives have to be reproducible
+		assert(Crc32("123456789") == 0xCBF43926);
+		assert(archive_writer::FormatFromExtension("docs.tgz") == archive_format::tar_gz);
+	}
+
+	TEST_METHOD(JsonRecord) {
+		const auto parameter = json_record().Field("name", "value").Field("out", true).str();
+		json_record record;
+		record.Field("kind", "method").Field("value", int64_t{ -1 }).OptionalField("deprecated", "")
+			.Field("doc", "line \"one\"\n\ttwo\x01").Field("implements", std::vector<std::string>{ "A.B" }).Records("parameters", { parameter });
+		assert(record.str() == R"({"kind":"method","value":-1,"deprecated":null,"doc":"line \"one\"\n\ttwo\u0001","implements":["A.B"],"parameters":[{"name":"value","out":true}]})");
+	}
+
+	TEST_METHOD(Snapshot) {
+		Program writer;
+		writer.Process({ "/outputSnapshot", "Test.snapshot", "..\\..\\x64\\Debug\\Test\\Test.winmd" });
+		const auto class1 = out_map["out\\Class1-api-windows.md"]->str();
+
+		{
+			mapped_file file("Test.snapshot");
+			snapshot_view snapshot(file.Contents().data(), file.Contents().size());
+			const auto type = snapshot.FindType("Test", "Class1");
+			assert(type && type->kind == model_kind::Class);
+			assert(snapshot[type->doc] == "Class doc_string");
+			const auto members = snapshot.Members().slice(type->members);
+			assert(members.size() == 2);
+			assert(snapshot[members[0].signature] == "int MyProperty");
+			assert(snapshot[members[0].defaultValue] == "MyProperty value");
+			assert(members[1].kind == model_kind::Constructor);
+		}
+
+		out_map.clear();
+		Program reader;
+		reader.Process({ "/fromSnapshot", "Test.snapshot" });
+		assert(out_map.size() == 3);
+		assert(out_map["out\\Class1-api-windows.md"]->str() == class1);
+	}
+
+	TEST_METHOD(SearchIndex) {
+		assert((search_index::SplitName("IXmlHttpRequest2") == std::vector<std::string>{ "i", "xml", "http", "request2" }));
+		assert((search_index::SplitText("Class2 implements @Interface1, see the f method") == std::vector<std::string>{ "class2", "implements", "interface1", "see", "method" }));
+
+		search_index index;
+		model_record type;
+		type.kind = model_kind::Class;
+		type.type = "Class1";
+		type.doc = "Class doc";
+		index.Add(type);
+		model_record property = type;
+		property.kind = model_kind::Property;
+		property.member = "MyProperty";
+		index.Add(property);
+		std::ostringstream json;
+		index.Write(json);
+		assert(json.str() == R"({"version":1,"docs":[["Class1","Class1"],["Class1.MyProperty","Class1#myproperty"]],"terms":["class","class1","doc","my","myproperty","property"],"postings":[[0,1],[0],[0,1],[1],[1],[1]]})" "\n");
+	}
+
+	TEST_METHOD(LinkCheck) {
+		link_checker links;
+		links.AddPage("Class1", "Implements: [`Interface1`](Interface1)\n\n## Properties\n### Properties\nSee [`Properties`](#properties-1) and [`g`](Interface1#g)\n```\n# not a heading\n```\nTest.Missing (unresolved reference)\n");
+		links.AddPage("Interface1", "## Methods\n### f\n");
+		links.AddLink("Test index", "Classes", "Class2");
+		const auto broken = links.Check();
+		assert(broken.size() == 3);
+		assert(broken[0].member == "Properties" && broken[0].target == "Interface1#g" && broken[0].reason == "no such anchor");
+		assert(broken[1].target == "Test.Missing" && broken[1].reason == "unresolved reference");
+		assert(broken[2].page == "Test index" && broken[2].reason == "no such page");
+		assert(link_checker::Slug("`Changed` event!") == "changed-event");
+	}
+
+	TEST_METHOD(ApiDiff) {
+		api_model before, after;
+		model_record type;
+		type.ns = "Test";
+		type.type = "Class1";
+		before.Add(type);
+		after.Add(type);
+		model_record property = type;
+		property.kind = model_kind::Property;
+		property.member = "MyProperty";
+		property.signature = "int MyProperty";
+		before.Add(property);
+		property.signature = "string MyProperty";
+		property.deprecated = "Use Other instead";
+		after.Add(property);
+		model_record method = type;
+		method.kind = model_kind::Method;
+		method.member = "f";
+		method.parameters = { { "a", "int", false } };
+		before.Add(method);
+		method.parameters = { { "a", "string", false } };
+		after.Add(method);
+
+		const auto changes = DiffApis(before, after);
+		assert(changes.size() == 3);
+		assert(changes[0].change == api_change::change_kind::Added && changes[0].name == "Test.Class1.f(string)");
+		assert(changes[1].change == api_change::change_kind::Removed && changes[1].name == "Test.Class1.f(int)");
+		assert(changes[2].name == "Test.Class1.MyProperty" && changes[2].fields.size() == 2);
+		assert(std::get<0>(changes[2].fields[1]) == "deprecated" && std::get<2>(changes[2].fields[1]) == "Use Other instead");
+	}
+
+	TEST_METHOD(ContentStore) {
+		const auto [frontMatter, body] = content_store::SplitFrontMatter("---\nid: version-0.64-Class1\ntitle: Class1\n---\n\nKind: `class`\n");
+		assert(frontMatter == "id: version-0.64-Class1\ntitle: Class1\n");
+		assert(body == "\nKind: `class`\n");
+		assert(content_store::SplitFrontMatter("Kind: `class`\n").second == "Kind: `class`\n");
+		assert(content_store::Hash("a") != content_store::Hash("b"));
+
+		// pages come out of text mode streams, so on Windows every line ends in \r\n
+		for (const auto* version : { "1", "2" }) {
+			std::filesystem::create_directories(std::string("store-v") + version);
+			std::ofstream(std::string("store-v") + version + "/Class1.md") << "---\nid: version-" << version << "-Class1\ntitle: Class1\n---\n\nKind: `class`\n";
+		}
+		content_store first("store"), second("store");
+		first.Add("store-v1/Class1.md");
+		first.Close("store-v1/front-matter.json");
+		second.Add("store-v2/Class1.md");
+		second.Close("store-v2/front-matter.json");
+		assert(first.Stored() == 1 && second.Shared() == 1);
+		std::ostringstream frontMatter;
+		frontMatter << std::ifstream("store-v2/front-matter.json", std::ios::binary).rdbuf();
+		assert(frontMatter.str().find("\"id\":\"version-2-Class1\"") != std::string::npos);
+		for (const auto* directory : { "store", "store-v1", "store-v2" }) {
+			std::filesystem::remove_all(directory);
+		}
+	}
+
+	TEST_METHOD(FanOut) {
+		program.ss.layout = page_layout::byHash;
+		const auto directory = program.ss.GetPageDirectory("Class1", "Test");
+		assert(directory.length() == 2);
+		assert(program.ss.GetLinkToType("Class1", directory, "Test") == "Class1");
+		assert(program.ss.GetLinkToType("Class1", "", "Test") == directory + "/Class1");
+		program.ss.layout = page_layout::byNamespace;
+		assert(program.ss.GetLinkToType("Class1", "Other", "Test") == "../Test/Class1");
+		assert(program.ss.GetIndexDirectory("Test") == "Test");
+		program.ss.layout = page_layout::flat;
+		assert(program.ss.GetLinkToType("Class1", "", "Test") == "Class1");
+
+		link_checker links;
+		links.AddPage("Class1", "See [`Interface1`](../1f/Interface1#f)\n");
+		links.AddPage("Interface1", "### f\n");
+		assert(links.Check().empty());
+	}
+
+	TEST_METHOD(IndexPages) {
+		// the pages of a split index go next to the index, wherever the type pages are
+		program.ss.layout = page_layout::byHash;
+		const auto index = program.ss.GetFileForType("index", "Test");
+		const auto page = program.ss.GetFileForType("index-classes-c", "Test");
+		assert(page.parent_path() == index.parent_path());
+		assert(page.filename() == "index-classes-c" + program.opts->fileSuffix + ".md");
+		program.ss.layout = page_layout::flat;
+
+		program.opts->indexPageSize = 1;
+		program.write_index("Split", { { model_kind::Class, { "Class1", "Class2" } }, { model_kind::Interface, { "Interface1" } } });
+		program.opts->indexPageSize = 0;
+		std::ostringstream toc;
+		toc << std::ifstream(program.ss.GetFileForType("index", "Split")).rdbuf();
+		assert(toc.str().find("## Classes\n- [`Classes (C)`](index-classes-c) (2)\n") != std::string::npos);
+		assert(toc.str().find("## Interfaces\n- [`Interfaces`](index-interfaces) (1)\n") != std::string::npos);
+		std::ostringstream classes;
+		classes << std::ifstream(program.ss.GetFileForType("index-classes-c", "Split")).rdbuf();
+		assert(classes.str().find("\n- [`Class1`](") != std::string::npos && classes.str().find("- - ") == std::string::npos);
+	}
+
+	TEST_METHOD(Html) {
+		const auto page = html_site::ToHtml("---\nid: Class1\ntitle: Class1\n---\n\nKind: `class`\n\n## Properties\n### MyProperty\n"
+			"|   | Name|Type|\n|---|-----|----|\n| | `A` | int |\n\n## Properties\n- See [`Class2`](../Other/Class2#f) <b>\n", "../winmd2md.css");
+		assert(page.find("<title>Class1</title>") != std::string::npos && page.find("href=\"../winmd2md.css\"") != std::string::npos);
+		assert(page.find("<p>Kind: <code>class</code></p>") != std::string::npos);
+		assert(page.find("<h2 id=\"properties-1\">") != std::string::npos);
+		assert(page.find("<tr><td></td><td><code>A</code></td><td>int</td></tr>") != std::string::npos);
+		assert(page.find("<li>See <a href=\"../Other/Class2.html#f\"><code>Class2</code></a> &lt;b&gt;</li>") != std::string::npos);
+		html_site site("out", program.opts->fileSuffix);
+		assert(site.HtmlPath("out/Test/Class1" + program.opts->fileSuffix + ".md") == std::filesystem::path("out/Test/Class1.html"));
+
+		// the flat layout's index is opened again for every namespace, and the last version has to be the one that stays
+		std::filesystem::create_directories("html");
+		{
+			html_site index("html", "");
+			for (int i = 0; i < 20; i++) {
+				*index.Open("html/index.md", false) << "---\ntitle: index\n---\n\nversion " << i << "\n";
+				index.Flush();
+			}
+			index.Wait();
+			assert(index.Written() == 20);
+		}
+		std::ostringstream written;
+		written << std::ifstream("html/index.html").rdbuf();
+		assert(written.str().find("version 19") != std::string::npos);
+		std::filesystem::remove_all("html");
+	}
+
+	TEST_METHOD(StagedFiles) {
+		std::filesystem::create_directories("staged");
+		staged_files files;
+		*files.Open("staged/A-api-windows.md", false) << "page A";
+		*files.Open("staged/A-api-windows.md", true) << ", referenced by B";
+		files.Commit();
+		assert(files.Written() == 1);
+		assert(staged_files::SameContents("staged/A-api-windows.md", "page A, referenced by B"));
+		*files.Open("staged/A-api-windows.md", false) << "page A, referenced by B";
+		files.Commit();
+		assert(files.Written() == 1 && files.Unchanged() == 1);
+		assert(!std::filesystem::exists("staged/A-api-windows.md.tmp"));
+
+		// more changed files in one directory than the CRT can have open at once
+		for (int i = 0; i < 600; i++) {
+			*files.Open("staged/" + std::to_string(i) + ".md", false) << "page " << i;
+		}
+		files.Commit();
+		assert(files.Written() == 601);
+		assert(staged_files::SameContents("staged/599.md", "page 599"));
+		std::filesystem::remove_all("staged");
+	}
+
+	TEST_METHOD(Incremental) {
+		auto makeRecord = [](std::string_view type, std::string doc) {
+			model_record r;
+			r.ns = "Test";
+			r.type = type;
+			r.doc = std::move(doc);
+			return r;
+		};
+		incremental_state before("options"), after("options");
+		before.Add(makeRecord("Class1", "doc"));
+		before.Add(makeRecord("Class2", "doc"));
+		before.Add(makeRecord("Class3", "doc"));
+		before.types["Test.Class1"].referrers = { "Test.Class2" };
+		after.Add(makeRecord("Class1", "new doc"));
+		after.Add(makeRecord("Class2", "doc"));
+		after.Add(makeRecord("Class3", "doc"));
+		after.types["Test.Class1"].referrers = { "Test.Class2" };
+
+		const auto plan = incremental_plan::Make(before, after);
+		assert(plan.pages == (std::set<std::string>{ "Test.Class1", "Test.Class2" }));
+		assert(plan.skipped == 1 && plan.indexes.empty() && plan.removed.empty());
+		assert(plan.Touches("Test") && !plan.Touches("Other"));
+		assert(incremental_plan::Make(before, incremental_state("other options")).pages.empty());
+		assert(incremental_plan::Make(before, incremental_state("other options")).removed.size() == 3);
+		assert(incremental_plan::Make(incremental_state("other options"), after).pages.size() == 3);
+	}
+
+	TEST_METHOD(TypeFilter) {
+		assert(type_filter::Glob("Micro*.React?ative", "Microsoft.ReactNative"));
+		assert(!type_filter::Glob("I*", "Class1"));
+		const type_filter filter("Test*", "Test.Internal", "I*;Test.Class1", "");
+		assert(filter.Matches("Test", "Interface1") && filter.Matches("Test", "Class1"));
+		assert(!filter.Matches("Test", "Class2") && !filter.Matches("Test.Internal", "Interface2") && !filter.Matches("Other", "Interface1"));
+		assert(!type_filter().Active());
+	}
+
+	TEST_METHOD(Shard) {
+		std::filesystem::create_directories("shards");
+		{
+			shard_writer first("1/2", "shards", "fp"), second("2/2", "shards", "fp");
+			for (auto* s : { &first, &second }) {
+				s->StartNamespace("NS");
+				for (const auto* name : { "A", "B", "C" }) {
+					const auto seq = s->NextType();
+					if (s->Owns("NS", name)) {
+						s->AddType(seq, model_kind::Class, "NS", name, std::string("<member name=\"T:NS.") + name + "\"/>\n");
+						s->AddImplementation("IFoo", "NS", name);
+					}
+				}
+				s->Close();
+			}
+			assert(first.Rendered() + second.Rendered() == 3);
+		}
+		shard_data data;
+		data.Read("shards", 2);
+		assert(data.fingerprint == "fp" && data.namespaces == std::vector<std::string>{ "NS" });
+		assert(data.types.size() == 3 && data.types[0].name == "A" && data.types[2].name == "C");
+		assert(data.implementations.size() == 3 && data.implementations[1].name == "B");
+		shard_data missing;
+		bool threw = false;
+		try { missing.Read("shards", 3); }
+		catch (const std::runtime_error&) { threw = true; }
+		assert(threw);
+	}
+
+	TEST_METHOD(InheritedMembers) {
+		// C derives from B derives from A; B and A both require IBase, which has to be resolved only once
+		std::map<std::string, inheritance_graph::type_info> types{
+			{ "NS.A", { { { model_kind::Method, "Run" }, { model_kind::Property, "Name" } }, { "NS.IBase" } } },
+			{ "NS.B", { { { model_kind::Method, "Run" }, { model_kind::Event, "Changed" } }, { "NS.A", "NS.IBase", "Other.Unknown" } } },
+			{ "NS.C", { { { model_kind::Method, "Stop" } }, { "NS.B" } } },
+			{ "NS.IBase", { { { model_kind::Method, "Close" } }, {} } },
+		};
+		int resolved = 0;
+		inheritance_graph graph([&](std::string_view name) -> std::optional<inheritance_graph::type_info> {
+			resolved++;
+			const auto t = types.find(std::string(name));
+			if (t == types.end()) return std::nullopt;
+			return t->second;
+		});
+		const auto& groups = *graph.Inherited("NS.C");
+		assert(groups.size() == 3 && groups[0].type == "NS.B" && groups[1].type == "NS.A" && groups[2].type == "NS.IBase");
+		assert(groups[0].members->size() == 2 && (*groups[0].members)[0]->name == "Changed" && (*groups[0].members)[1]->name == "Run");
+		assert(groups[1].members->size() == 1 && (*groups[1].members)[0]->name == "Name");
+		assert(resolved == 5 && graph.Get("NS.A") == graph.Get("NS.B")->bases[0]);
+		// B's list was worked out for C, and C declares nothing that hides any of it, so C shares its groups
+		const auto b = graph.Inherited("NS.B");
+		assert(b == graph.Inherited("NS.B") && b->size() == 2);
+		assert((*b)[0].members == groups[1].members && (*b)[1].members == groups[2].members);
+	}
+
+	TEST_METHOD(XrefMap) {
+		std::ofstream("contoso.yml") << "### YamlMime:XRefMap\nbaseUrl: https://contoso.dev/api/\nreferences:\n"
+			"- uid: Contoso.Widget\n  name: Widget\n  href: Contoso.Widget.html\n- href: https://elsewhere/resize\n  uid: \"Contoso.Widget.Resize*\"\n";
+		std::ofstream("fabrikam.txt") << "Contoso.Widget\thttps://ignored\nFabrikam.Gadget\thttps://fabrikam.dev/Gadget\n";
+		xref_map xrefs;
+		xrefs.Load("contoso.yml");
+		xrefs.Load("fabrikam.txt");
+		assert(xrefs.Size() == 3);
+		assert(xrefs.Find("Contoso.Widget") == "https://contoso.dev/api/Contoso.Widget.html");
+		assert(xrefs.Find("Contoso.Widget.Resize*") == "https://elsewhere/resize");
+		assert(xrefs.Find("Fabrikam.Gadget") == "https://fabrikam.dev/Gadget");
+		assert(xrefs.Find("Fabrikam").empty());
+
+		// incremental state and shards key on what the maps say, not where they were loaded from
+		xref_map same, moved;
+		same.Load("contoso.yml");
+		same.Load("fabrikam.txt");
+		moved.Add("Contoso.Widget", "https://contoso.dev/api/Contoso.Widget.html");
+		moved.Add("Contoso.Widget.Resize*", "https://elsewhere/resize");
+		moved.Add("Fabrikam.Gadget", "https://fabrikam.dev/v2/Gadget");
+		assert(same.ContentHash() == xrefs.ContentHash() && moved.ContentHash() != xrefs.ContentHash());
+	}
+
+	TEST_METHOD(RenderOrder) {
+		// classes are rendered before the interfaces of their namespace, so a full run lists Class1 on Interface1's page
+		const auto class1 = program.cache->find("Test", "Class1");
+		const auto interface1 = program.cache->find("Test", "Interface1");
+		assert(program.RenderedBefore(interface1, class1));
+		program.RecordRenderOrder();
+		assert(program.RenderedBefore(class1, interface1) && !program.RenderedBefore(interface1, class1));
+		program.renderOrder.clear();
+	}
+
+	TEST_METHOD(GzipSiblings) {
+		// the flat layout rewrites its index after every namespace, while the last version may still be compressing
+		const std::filesystem::path file = "siblings.md";
+		std::string last;
+		{
+			gzip_siblings siblings;
+			for (int i = 0; i < 50; i++) {
+				siblings.Add(file);
+				last = std::string(5000 + i, static_cast<char>('a' + i % 26));
+				std::ofstream(file, std::ios::binary) << last;
+				siblings.Flush();
+			}
+			siblings.Wait();
+			assert(siblings.Written() + siblings.Kept() == 50);
+		}
+		std::ostringstream gz;
+		gz << std::ifstream("siblings.md.gz", std::ios::binary).rdbuf();
+		assert(gz.str() == ::Gzip(last));
+		for (const auto& entry : std::filesystem::directory_iterator(".")) {
+			assert(entry.path().extension() != ".tmp");
+		}
+	}
+
+	TEST_METHOD(WatchUnchanged) {
+		// what /watch runs for each change: the first run writes every page, and a rebuild that leaves the metadata
+		// alone writes none
+		const auto pages = out_map;
+		const auto stateFile = std::filesystem::path(program.opts->outputDirectory) / "winmd2md.state";
+		std::filesystem::remove(stateFile);
+		program.opts->incremental = true;
+		out_map.clear();
+		program.Regenerate(program.getWindowsWinMd(), program.opts->winMDPath);
+		assert(out_map.size() == 3);
+		out_map.clear();
+		program.Regenerate(program.getWindowsWinMd(), program.opts->winMDPath);
+		assert(out_map.empty() && !program.ss.pageFilter);
+		program.opts->incremental = false;
+		program.renderOrder.clear();
+		std::filesystem::remove(stateFile);
+		out_map = pages;
+	}
+
+	TEST_METHOD(ReferenceSpill) {
+		// a tiny budget forces a run per edge, so the merge has to stitch everything back together
+		reference_spill spill("references.edges", 1);
+		spill.Add("NS", "B", "NS", "Z");
+		spill.Add("NS", "A", "Other", "Y");
+		spill.Add("NS", "B", "NS", "C");
+		spill.Add("NS", "B", "NS", "Z");
+		assert(spill.RunCount() == 4);
+
+		std::vector<std::string> merged;
+		spill.Merge([&merged](const std::string& ns, const std::string& type, const std::vector<std::string>& referrers) {
+			std::string line = ns + "." + type + ":";
+			for (const auto& r : referrers) line += " " + r;
+			merged.push_back(line);
+		});
+		assert((merged == std::vector<std::string>{ "NS.A: Y", "NS.B: C Z" }));
+	}
 };
 
 Program UnitTests::program;
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <tuple>
+
+#include "ApiDiff.h"
+#include "NdJson.h"
+
+using namespace std;
+
+namespace {
+  // FNV-1a; the hash only has to tell two versions of the same entity apart
+  uint64_t Hash(uint64_t h, string_view data) {
+    for (const auto c : data) {
+      h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+    }
+    return (h ^ 0xff) * 0x100000001b3ull; // field separator, so "ab","c" and "a","bc" differ
+  }
+
+  string Join(const vector<string>& values) {
+    string joined;
+    for (const auto& v : values) {
+      if (!joined.empty()) joined += ", ";
+      joined += v;
+    }
+    return joined;
+  }
+
+  string_view ToString(api_change::change_kind change) {
+    switch (change) {
+    case api_change::change_kind::Added: return "added";
+    case api_change::change_kind::Removed: return "removed";
+    default: return "changed";
+    }
+  }
+}
+
+void api_model::Add(const model_record& record) {
+  string name = string(record.ns) + "." + string(record.type);
+  entity e{ record.kind, record.signature, {}, 0 };
+  if (IsType(record.kind)) {
+    e.fields.emplace_back("extends", record.valueType);
+    e.fields.emplace_back("implements", Join(record.implements));
+  }
+  else {
+    name += "." + string(record.member);
+    if (record.kind == model_kind::Method || record.kind == model_kind::Constructor) {
+      vector<string> types;
+      for (const auto& p : record.parameters) {
+        types.push_back((p.out ? "out " : "") + p.type);
+      }
+      name += "(" + Join(types) + ")";
+    }
+    e.fields.emplace_back("signature", record.signature);
+  }
+  e.fields.emplace_back("experimental", record.experimental ? "yes" : "no");
+  e.fields.emplace_back("deprecated", record.deprecated);
+  e.fields.emplace_back("default", record.defaultValue);
+
+  e.hash = Hash(0xcbf29ce484222325ull, ToString(record.kind));
+  for (const auto& [field, value] : e.fields) {
+    e.hash = Hash(e.hash, value);
+  }
+  entities.insert_or_assign(std::move(name), std::move(e));
+}
+
+vector<api_change> DiffApis(const api_model& from, const api_model& to) {
+  vector<api_change> changes;
+  for (const auto& [name, after] : to.entities) {
+    const auto before = from.entities.find(name);
+    if (before == from.entities.end()) {
+      changes.push_back({ api_change::change_kind::Added, name, after.kind, after.signature, {} });
+    }
+    else if (before->second.hash != after.hash || before->second.kind != after.kind) {
+      api_change c{ api_change::change_kind::Changed, name, after.kind, after.signature, {} };
+      if (before->second.kind != after.kind) {
+        c.fields.emplace_back("kind", ToString(before->second.kind), ToString(after.kind));
+      }
+      for (const auto& [field, value] : after.fields) {
+        const auto old = find_if(before->second.fields.begin(), before->second.fields.end(), [field = field](const auto& f) { return f.first == field; });
+        const auto& oldValue = old == before->second.fields.end() ? string() : old->second;
+        if (oldValue != value) {
+          c.fields.emplace_back(field, oldValue, value);
+        }
+      }
+      changes.push_back(std::move(c));
+    }
+  }
+  for (const auto& [name, before] : from.entities) {
+    if (to.entities.find(name) == to.entities.end()) {
+      changes.push_back({ api_change::change_kind::Removed, name, before.kind, before.signature, {} });
+    }
+  }
+  sort(changes.begin(), changes.end(), [](const api_change& a, const api_change& b) {
+    return tie(a.change, a.name) < tie(b.change, b.name);
+  });
+  return changes;
+}
+
+void WriteChangelogMarkdown(ostream& out, const vector<api_change>& changes, string_view fromName, string_view toName) {
+  out << "# API changes from " << fromName << " to " << toName << "\n";
+  if (changes.empty()) {
+    out << "\nNo changes\n";
+    return;
+  }
+  constexpr pair<api_change::change_kind, string_view> sections[] = {
+    { api_change::change_kind::Added, "Added" },
+    { api_change::change_kind::Removed, "Removed" },
+    { api_change::change_kind::Changed, "Changed" },
+  };
+  for (const auto& [change, heading] : sections) {
+    bool first = true;
+    for (const auto& c : changes) {
+      if (c.change != change) continue;
+      if (first) {
+        out << "\n## " << heading << "\n";
+        first = false;
+      }
+      out << "- " << ToString(c.kind) << " `" << c.name << "`";
+      if (change != api_change::change_kind::Changed && !c.signature.empty()) {
+        out << ": `" << c.signature << "`";
+      }
+      out << "\n";
+      for (const auto& [field, before, after] : c.fields) {
+        out << "  - " << field << ": " << (before.empty() ? "(none)" : "`" + before + "`") << " -> " << (after.empty() ? "(none)" : "`" + after + "`") << "\n";
+      }
+    }
+  }
+}
+
+void WriteChangelogJson(ostream& out, const vector<api_change>& changes, string_view fromName, string_view toName) {
+  vector<string> entries;
+  for (const auto& c : changes) {
+    json_record entry;
+    entry.Field("change", ToString(c.change)).Field("kind", ToString(c.kind)).Field("name", c.name).OptionalField("signature", c.signature);
+    vector<string> fields;
+    for (const auto& [field, before, after] : c.fields) {
+      fields.push_back(json_record().Field("field", field).Field("old", before).Field("new", after).str());
+    }
+    entry.Records("fields", fields);
+    entries.push_back(entry.str());
+  }
+  out << json_record().Field("from", fromName).Field("to", toName).Records("changes", entries).str() << "\n";
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Model.h"
+
+/// <summary>
+/// The public surface of one API version for /diffFrom: every type and member keyed by identity (Ns.Type, Ns.Type.Member,
+/// and for methods the parameter types as well, so overloads stay apart), with the facts a changelog cares about and a
+/// hash of them. Two versions are compared entity by entity, and only entities whose hashes differ are compared field by
+/// field. Doc text isn't part of the surface.
+/// </summary>
+struct api_model
+{
+  struct entity {
+    model_kind kind;
+    std::string signature;
+    /// (name, value) pairs in a fixed order per kind
+    std::vector<std::pair<std::string_view, std::string>> fields;
+    uint64_t hash;
+  };
+
+  void Add(const model_record& record);
+  size_t Size() const { return entities.size(); }
+
+  std::unordered_map<std::string, entity> entities;
+};
+
+struct api_change
+{
+  enum class change_kind { Added, Removed, Changed };
+  change_kind change;
+  std::string name;
+  model_kind kind;
+  std::string signature;
+  /// field, old value, new value
+  std::vector<std::tuple<std::string, std::string, std::string>> fields;
+};
+
+/// The changes that take from to to, sorted by name.
+std::vector<api_change> DiffApis(const api_model& from, const api_model& to);
+
+void WriteChangelogMarkdown(std::ostream& out, const std::vector<api_change>& changes, std::string_view fromName, std::string_view toName);
+void WriteChangelogJson(std::ostream& out, const std::vector<api_change>& changes, std::string_view fromName, std::string_view toName);
@@ -0,0 +1,250 @@
+#include <cstring>
+#include <stdexcept>
+
+#include "Archive.h"
+
+using namespace std;
+
+namespace {
+  void Append16(string& out, uint16_t v) {
+    out.push_back(static_cast<char>(v & 0xff));
+    out.push_back(static_cast<char>(v >> 8));
+  }
+
+  void Append32(string& out, uint32_t v) {
+    Append16(out, static_cast<uint16_t>(v & 0xffff));
+    Append16(out, static_cast<uint16_t>(v >> 16));
+  }
+
+  // 1980-01-01 00:00, the earliest DOS date; real timestamps would make every archive different
+  constexpr uint16_t dosTime = 0;
+  constexpr uint16_t dosDate = (0 << 9) | (1 << 5) | 1;
+  constexpr uint16_t utf8Names = 0x0800;
+  constexpr uint16_t zipVersion = 20;
+  constexpr uint16_t stored = 0;
+  constexpr uint16_t deflated = 8;
+
+  constexpr size_t tarBlock = 512;
+
+  void Octal(char* field, size_t width, uint64_t value) {
+    // width - 1 digits followed by a NUL
+    for (size_t i = width - 1; i-- > 0;) {
+      field[i] = static_cast<char>('0' + (value & 7));
+      value >>= 3;
+    }
+    field[width - 1] = '\0';
+  }
+
+  string TarHeader(string_view name, uint64_t size, char type) {
+    string header(tarBlock, '\0');
+    char* h = header.data();
+    memcpy(h, name.data(), min<size_t>(name.length(), 100));
+    Octal(h + 100, 8, 0644);
+    Octal(h + 108, 8, 0);
+    Octal(h + 116, 8, 0);
+    Octal(h + 124, 12, size);
+    Octal(h + 136, 12, 0);
+    memset(h + 148, ' ', 8);
+    h[156] = type;
+    memcpy(h + 257, "ustar", 6);
+    memcpy(h + 263, "00", 2);
+    uint32_t checksum = 0;
+    for (const auto c : header) {
+      checksum += static_cast<unsigned char>(c);
+    }
+    Octal(h + 148, 7, checksum);
+    return header;
+  }
+
+  void AppendTarEntry(string& tar, string_view name, string_view data) {
+    if (name.length() > 100) {
+      // a pax extended header carries names that don't fit; each record is "<length> path=<name>\n"
+      const string record = " path=" + string(name) + "\n";
+      auto length = record.length() + 1;
+      while (to_string(length).length() + record.length() != length) length++;
+      const auto pax = to_string(length) + record;
+      tar += TarHeader("PaxHeader", pax.length(), 'x');
+      tar += pax;
+      tar.append((tarBlock - pax.length() % tarBlock) % tarBlock, '\0');
+    }
+    tar += TarHeader(name, data.length(), '0');
+    tar += data;
+    tar.append((tarBlock - data.length() % tarBlock) % tarBlock, '\0');
+  }
+}
+
+archive_format archive_writer::FormatFromExtension(const filesystem::path& archiveFile) {
+  const auto name = archiveFile.filename().u8string();
+  auto endsWith = [&name](string_view suffix) {
+    return name.length() >= suffix.length() && string_view(name).substr(name.length() - suffix.length()) == suffix;
+  };
+  if (endsWith(".zip")) return archive_format::zip;
+  if (endsWith(".tar.gz") || endsWith(".tgz")) return archive_format::tar_gz;
+  if (endsWith(".tar")) return archive_format::tar;
+  throw std::invalid_argument("Unsupported archive type for " + name + "; use .zip, .tar.gz, .tgz or .tar (zstd isn't available in this build)");
+}
+
+archive_writer::archive_writer(const filesystem::path& archiveFile) : format(FormatFromExtension(archiveFile)), path(archiveFile) {
+  if (archiveFile.has_parent_path()) {
+    filesystem::create_directories(archiveFile.parent_path());
+  }
+  file.open(archiveFile, ios::binary | ios::trunc);
+  if (!file) {
+    throw std::runtime_error("Failed to create archive " + archiveFile.u8string());
+  }
+}
+
+archive_writer::~archive_writer() {
+  if (file.is_open()) {
+    file.close();
+    std::error_code ec;
+    filesystem::remove(path, ec);
+  }
+}
+
+shared_ptr<ostream> archive_writer::Open(const string& name, bool append) {
+  if (append && written.find(name) != written.end()) {
+    throw std::logic_error(name + " was already written to the archive; /outputArchive can't be combined with /streaming");
+  }
+  auto& stream = pending[name];
+  if (!stream || !append) {
+    stream = make_shared<ostringstream>();
+  }
+  return stream;
+}
+
+void archive_writer::Submit(function<piece()> job) {
+  inFlight.push_back(pool.Submit(std::move(job)));
+  // bound how much compressed output waits in memory for an earlier piece to finish
+  Drain(4 * pool.Size());
+}
+
+void archive_writer::Drain(size_t keep) {
+  while (inFlight.size() > keep) {
+    Write(inFlight.front().get());
+    inFlight.pop_front();
+  }
+}
+
+void archive_writer::Write(piece&& p) {
+  if (format == archive_format::zip) {
+    directory.push_back({ std::move(p.name), p.crc, p.bytes.size(), p.size, p.method, position });
+    const auto& e = directory.back();
+    if (e.offset > UINT32_MAX || e.size > UINT32_MAX || directory.size() > UINT16_MAX) {
+      throw std::length_error("The docs are too large for a zip without zip64 extensions; use .tar.gz instead");
+    }
+    string header;
+    Append32(header, 0x04034b50);
+    Append16(header, zipVersion);
+    Append16(header, utf8Names);
+    Append16(header, e.method);
+    Append16(header, dosTime);
+    Append16(header, dosDate);
+    Append32(header, e.crc);
+    Append32(header, static_cast<uint32_t>(e.compressedSize));
+    Append32(header, static_cast<uint32_t>(e.size));
+    Append16(header, static_cast<uint16_t>(e.name.length()));
+    Append16(header, 0);
+    header += e.name;
+    file.write(header.data(), header.size());
+    position += header.size();
+  }
+  file.write(p.bytes.data(), p.bytes.size());
+  position += p.bytes.size();
+}
+
+void archive_writer::SubmitTar(string& tar, bool last) {
+  while (tar.length() >= tarChunkSize || (last && !tar.empty())) {
+    const auto n = min(tar.length(), tarChunkSize);
+    auto chunk = make_shared<string>(tar.substr(0, n));
+    tar.erase(0, n);
+    if (format == archive_format::tar_gz) {
+      Submit([chunk]() { return piece{ Gzip(*chunk) }; });
+    }
+    else {
+      Submit([chunk]() { return piece{ std::move(*chunk) }; });
+    }
+  }
+}
+
+void archive_writer::Flush() {
+  for (auto& [name, stream] : pending) {
+    written.insert(name);
+    if (format == archive_format::zip) {
+      auto data = make_shared<string>(stream->str());
+      Submit([name = name, data]() {
+        piece p{ Deflate(*data), name, Crc32(*data), data->size(), deflated };
+        if (p.bytes.size() >= data->size()) {
+          p.bytes = std::move(*data);
+          p.method = stored;
+        }
+        return p;
+      });
+    }
+    else {
+      AppendTarEntry(tarBuffer, name, stream->str());
+    }
+  }
+  pending.clear();
+  if (format != archive_format::zip) {
+    SubmitTar(tarBuffer, false);
+  }
+}
+
+void archive_writer::Close() {
+  Flush();
+  if (format == archive_format::zip) {
+    Drain(0);
+    // A file written again later (like the index, once per namespace) keeps its earlier bytes as dead space;
+    // only its last copy goes into the central directory
+    map<string_view, size_t> latest;
+    for (size_t i = 0; i < directory.size(); i++) {
+      latest[directory[i].name] = i;
+    }
+    string central;
+    for (const auto& [name, i] : latest) {
+      const auto& e = directory[i];
+      Append32(central, 0x02014b50);
+      Append16(central, zipVersion);
+      Append16(central, zipVersion);
+      Append16(central, utf8Names);
+      Append16(central, e.method);
+      Append16(central, dosTime);
+      Append16(central, dosDate);
+      Append32(central, e.crc);
+      Append32(central, static_cast<uint32_t>(e.compressedSize));
+      Append32(central, static_cast<uint32_t>(e.size));
+      Append16(central, static_cast<uint16_t>(e.name.length()));
+      Append16(central, 0); // extra
+      Append16(central, 0); // comment
+      Append16(central, 0); // disk
+      Append16(central, 0); // internal attributes
+      Append32(central, 0); // external attributes
+      Append32(central, static_cast<uint32_t>(e.offset));
+      central += e.name;
+    }
+    if (position > UINT32_MAX) {
+      throw std::length_error("The docs are too large for a zip without zip64 extensions; use .tar.gz instead");
+    }
+    string end;
+    Append32(end, 0x06054b50);
+    Append16(end, 0);
+    Append16(end, 0);
+    Append16(end, static_cast<uint16_t>(latest.size()));
+    Append16(end, static_cast<uint16_t>(latest.size()));
+    Append32(end, static_cast<uint32_t>(central.size()));
+    Append32(end, static_cast<uint32_t>(position));
+    Append16(end, 0);
+    file.write(central.data(), central.size());
+    file.write(end.data(), end.size());
+  }
+  else {
+    tarBuffer.append(2 * tarBlock, '\0'); // end of archive
+    SubmitTar(tarBuffer, true);
+    Drain(0);
+  }
+  file.close();
+  if (file.fail()) {
+    throw std::runtime_error("Failed to write archive");
+  }
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Compression.h"
+#include "Package.h"
+
+enum class archive_format
+{
+  tar,
+  tar_gz,
+  zip,
+};
+
+/// <summary>
+/// Streams pages straight into an archive (/outputArchive), picked by extension: .zip, .tar.gz/.tgz or .tar.
+/// Compression runs on a worker pool in independent pieces: one deflate stream per zip entry, or one gzip member per
+/// chunk of the tar stream (concatenated members are a valid .gz). Pieces are written in the order they were
+/// submitted and entries are sorted by name within each namespace with zeroed timestamps, so the same input always
+/// produces the same archive.
+/// </summary>
+struct archive_writer : package_writer
+{
+  archive_writer(const std::filesystem::path& archiveFile);
+  ~archive_writer() override;
+
+  std::shared_ptr<std::ostream> Open(const std::string& name, bool append) override;
+  void Flush() override;
+  void Close() override;
+
+  static archive_format FormatFromExtension(const std::filesystem::path& archiveFile);
+
+  static constexpr size_t tarChunkSize = 1 << 20;
+
+private:
+  struct piece {
+    std::string bytes;
+    // zip only
+    std::string name;
+    uint32_t crc = 0;
+    uint64_t size = 0;
+    uint16_t method = 0;
+  };
+  struct directory_entry {
+    std::string name;
+    uint32_t crc;
+    uint64_t compressedSize;
+    uint64_t size;
+    uint16_t method;
+    uint64_t offset;
+  };
+
+  void Submit(std::function<piece()> job);
+  void Drain(size_t keep);
+  void Write(piece&& p);
+  void SubmitTar(std::string& tar, bool last);
+
+  archive_format format;
+  std::filesystem::path path;
+  std::ofstream file;
+  uint64_t position = 0;
+  std::map<std::string, std::shared_ptr<std::ostringstream>> pending;
+  std::set<std::string> written;
+  std::string tarBuffer;
+  worker_pool pool;
+  std::deque<std::future<piece>> inFlight;
+  std::vector<directory_entry> directory;
+};
@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "Bundle.h"
+
+using namespace std;
+
+namespace {
+  template<typename T>
+  void WriteValue(ostream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  template<typename T>
+  T ReadValue(const char*& p) {
+    T value;
+    memcpy(&value, p, sizeof(value));
+    p += sizeof(value);
+    return value;
+  }
+}
+
+bundle_writer::bundle_writer(const filesystem::path& bundleFile) : path(bundleFile) {
+  if (bundleFile.has_parent_path()) {
+    filesystem::create_directories(bundleFile.parent_path());
+  }
+  file.open(bundleFile, ios::binary | ios::in | ios::out | ios::trunc);
+  if (!file) {
+    throw std::runtime_error("Failed to create bundle " + bundleFile.u8string());
+  }
+}
+
+bundle_writer::~bundle_writer() {
+  if (file.is_open()) {
+    file.close();
+    std::error_code ec;
+    filesystem::remove(path, ec);
+  }
+}
+
+shared_ptr<ostream> bundle_writer::Open(const string& name, bool append) {
+  auto& stream = pending[name];
+  if (!stream || !append) {
+    stream = make_shared<ostringstream>();
+  }
+  if (!append) {
+    entries.erase(name); // rewritten from scratch; whatever was flushed before is dead space now
+  }
+  return stream;
+}
+
+void bundle_writer::Write(string_view bytes, vector<extent>& extents) {
+  file.seekp(position);
+  file.write(bytes.data(), bytes.length());
+  extents.push_back({ position, bytes.length() });
+  position += bytes.length();
+}
+
+void bundle_writer::Flush() {
+  for (const auto& [name, stream] : pending) {
+    Write(stream->str(), entries[name]);
+  }
+  pending.clear();
+}
+
+void bundle_writer::Close() {
+  Flush();
+
+  // Entries that were appended to after a flush are in several pieces; copy them to the end in one
+  for (auto& [name, extents] : entries) {
+    if (extents.size() < 2) continue;
+    string joined;
+    for (const auto& e : extents) {
+      const auto start = joined.size();
+      joined.resize(start + e.length);
+      file.seekg(e.offset);
+      file.read(joined.data() + start, e.length);
+    }
+    extents.clear();
+    Write(joined, extents);
+  }
+
+  file.seekp(position);
+  const auto indexOffset = position;
+  for (const auto& [name, extents] : entries) {
+    const auto& e = extents.empty() ? extent{ indexOffset, 0 } : extents.front();
+    WriteValue(file, static_cast<uint32_t>(name.length()));
+    file.write(name.data(), name.length());
+    WriteValue(file, e.offset);
+    WriteValue(file, e.length);
+  }
+  WriteValue(file, indexOffset);
+  WriteValue(file, static_cast<uint32_t>(entries.size()));
+  WriteValue(file, bundle_format::version);
+  file.write(bundle_format::magic, sizeof(bundle_format::magic));
+  file.close();
+  if (file.fail()) {
+    throw std::runtime_error("Failed to write bundle");
+  }
+}
+
+bundle_reader::bundle_reader(const filesystem::path& bundleFile) : file(bundleFile) {
+  auto fail = [&bundleFile](const char* why) {
+    return std::runtime_error(bundleFile.u8string() + ": " + why);
+  };
+  const char* const data = file.Contents().data();
+  const auto size = file.Contents().size();
+  if (size < bundle_format::trailerSize) {
+    throw fail("not a bundle");
+  }
+
+  const char* trailer = data + size - bundle_format::trailerSize;
+  const auto indexOffset = ReadValue<uint64_t>(trailer);
+  const auto count = ReadValue<uint32_t>(trailer);
+  const auto version = ReadValue<uint32_t>(trailer);
+  if (memcmp(trailer, bundle_format::magic, sizeof(bundle_format::magic)) != 0 || version != bundle_format::version || indexOffset > size - bundle_format::trailerSize) {
+    throw fail("not a bundle, or written by a different version");
+  }
+
+  const char* p = data + indexOffset;
+  const char* const indexEnd = data + size - bundle_format::trailerSize;
+  entries.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    if (indexEnd - p < static_cast<ptrdiff_t>(sizeof(uint32_t))) break;
+    const auto nameLength = ReadValue<uint32_t>(p);
+    if (static_cast<uint64_t>(indexEnd - p) < nameLength + 2 * sizeof(uint64_t)) break;
+    const string_view name(p, nameLength);
+    p += nameLength;
+    const auto offset = ReadValue<uint64_t>(p);
+    const auto length = ReadValue<uint64_t>(p);
+    if (offset > indexOffset || length > indexOffset - offset) break;
+    entries.push_back({ name, string_view(data + offset, static_cast<size_t>(length)) });
+  }
+  if (entries.size() != count) {
+    throw fail("the index is corrupt");
+  }
+}
+
+optional<string_view> bundle_reader::Find(string_view name) const {
+  // the index is sorted by name
+  const auto it = lower_bound(entries.begin(), entries.end(), name, [](const entry& e, string_view n) { return e.name < n; });
+  if (it == entries.end() || it->name != name) {
+    return nullopt;
+  }
+  return it->contents;
+}
+
+size_t bundle_reader::ExtractTo(const filesystem::path& directory) const {
+  for (const auto& e : entries) {
+    const auto target = directory / filesystem::u8path(e.name);
+    const auto relative = target.lexically_relative(directory);
+    if (relative.empty() || *relative.begin() == "..") {
+      throw std::runtime_error("bundle entry escapes the output directory: " + string(e.name));
+    }
+    filesystem::create_directories(target.parent_path());
+    ofstream out(target, ios::binary | ios::trunc);
+    out.write(e.contents.data(), e.contents.length());
+    if (!out) {
+      throw std::runtime_error("Failed to write " + target.u8string());
+    }
+  }
+  return entries.size();
+}
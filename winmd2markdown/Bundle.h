@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "MappedFile.h"
+#include "Package.h"
+
+/// <summary>
+/// Single-file output (/outputBundle). Every file's bytes are stored back to back, followed by an index and a
+/// fixed-size trailer:
+///   index:   per entry, u32 name length, name (UTF-8, '/' separated), u64 offset, u64 length; sorted by name
+///   trailer: u64 index offset, u32 entry count, u32 format version, 8 byte magic "W2MDBNDL"
+/// Each entry is contiguous, so a reader can map the bundle and hand out pages without copying them.
+/// </summary>
+namespace bundle_format {
+  constexpr char magic[8] = { 'W', '2', 'M', 'D', 'B', 'N', 'D', 'L' };
+  constexpr uint32_t version = 1;
+  constexpr size_t trailerSize = sizeof(uint64_t) + 2 * sizeof(uint32_t) + sizeof(magic);
+}
+
+/// <summary>
+/// Writes a bundle. Buffering until Flush means most pages are written once and in one piece; a file that is
+/// appended to after it was flushed (/streaming) is moved to the end of the bundle in one piece when it's closed.
+/// </summary>
+struct bundle_writer : package_writer
+{
+  bundle_writer(const std::filesystem::path& bundleFile);
+  ~bundle_writer() override;
+
+  std::shared_ptr<std::ostream> Open(const std::string& name, bool append) override;
+  void Flush() override;
+  void Close() override;
+
+private:
+  struct extent {
+    uint64_t offset;
+    uint64_t length;
+  };
+
+  void Write(std::string_view bytes, std::vector<extent>& extents);
+
+  std::filesystem::path path;
+  std::fstream file;
+  uint64_t position = 0;
+  std::map<std::string, std::shared_ptr<std::ostringstream>> pending;
+  std::map<std::string, std::vector<extent>> entries;
+};
+
+/// <summary>
+/// Maps a bundle read-only. Contents() points into the mapping, so it's valid as long as the reader is alive.
+/// </summary>
+struct bundle_reader
+{
+  bundle_reader(const std::filesystem::path& bundleFile);
+
+  struct entry {
+    std::string_view name;
+    std::string_view contents;
+  };
+
+  const std::vector<entry>& Entries() const { return entries; }
+  /// Returns the contents of the named file, or an empty optional if the bundle doesn't have it.
+  std::optional<std::string_view> Find(std::string_view name) const;
+
+  /// Writes every entry under directory, recreating the usual output tree. Returns the number of files written.
+  size_t ExtractTo(const std::filesystem::path& directory) const;
+
+private:
+  mapped_file file;
+  std::vector<entry> entries;
+};
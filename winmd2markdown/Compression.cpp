@@ -0,0 +1,273 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+#include "Compression.h"
+
+using namespace std;
+
+namespace {
+  constexpr array<uint32_t, 256> MakeCrcTable() {
+    array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++) {
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      }
+      table[i] = c;
+    }
+    return table;
+  }
+  constexpr auto crcTable = MakeCrcTable();
+
+  // Deflate writes bits starting from the least significant end; Huffman codes go out most significant bit first
+  struct bit_writer {
+    string& out;
+    uint64_t buffer = 0;
+    uint32_t count = 0;
+
+    void Bits(uint32_t value, uint32_t n) {
+      buffer |= static_cast<uint64_t>(value) << count;
+      count += n;
+      while (count >= 8) {
+        out.push_back(static_cast<char>(buffer & 0xff));
+        buffer >>= 8;
+        count -= 8;
+      }
+    }
+
+    void Code(uint32_t code, uint32_t n) {
+      uint32_t reversed = 0;
+      for (uint32_t i = 0; i < n; i++) {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+      }
+      Bits(reversed, n);
+    }
+
+    void Finish() {
+      if (count > 0) {
+        out.push_back(static_cast<char>(buffer & 0xff));
+      }
+      buffer = 0;
+      count = 0;
+    }
+  };
+
+  void Literal(bit_writer& bits, uint32_t symbol) {
+    if (symbol < 144) bits.Code(0x30 + symbol, 8);
+    else if (symbol < 256) bits.Code(0x190 + symbol - 144, 9);
+    else if (symbol < 280) bits.Code(symbol - 256, 7);
+    else bits.Code(0xc0 + symbol - 280, 8);
+  }
+
+  constexpr uint16_t lengthBase[] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+  constexpr uint8_t lengthExtra[] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+  constexpr uint16_t distanceBase[] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+  constexpr uint8_t distanceExtra[] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+  void Match(bit_writer& bits, uint32_t length, uint32_t distance) {
+    const auto l = static_cast<uint32_t>(upper_bound(begin(lengthBase), end(lengthBase), length) - begin(lengthBase) - 1);
+    Literal(bits, 257 + l);
+    bits.Bits(length - lengthBase[l], lengthExtra[l]);
+    const auto d = static_cast<uint32_t>(upper_bound(begin(distanceBase), end(distanceBase), distance) - begin(distanceBase) - 1);
+    bits.Code(d, 5);
+    bits.Bits(distance - distanceBase[d], distanceExtra[d]);
+  }
+
+  constexpr uint32_t windowSize = 32768;
+  constexpr uint32_t minMatch = 3;
+  constexpr uint32_t maxMatch = 258;
+  constexpr uint32_t maxChain = 64;
+  constexpr uint32_t hashBits = 15;
+
+  uint32_t Hash(const unsigned char* p) {
+    return ((p[0] << 10) ^ (p[1] << 5) ^ p[2]) & ((1 << hashBits) - 1);
+  }
+}
+
+uint32_t Crc32(string_view data, uint32_t crc) {
+  crc = ~crc;
+  for (const auto c : data) {
+    crc = crcTable[(crc ^ static_cast<unsigned char>(c)) & 0xff] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+string Deflate(string_view data) {
+  string out;
+  out.reserve(data.length() / 2 + 16);
+  bit_writer bits{ out };
+  bits.Bits(1, 1); // BFINAL: everything goes in one block
+  bits.Bits(1, 2); // BTYPE 01: fixed Huffman codes
+
+  const auto input = reinterpret_cast<const unsigned char*>(data.data());
+  const auto length = static_cast<uint32_t>(data.length());
+  constexpr int32_t none = -1;
+  vector<int32_t> head(size_t{ 1 } << hashBits, none);
+  vector<int32_t> previous(windowSize, none);
+  auto insert = [&](uint32_t pos) {
+    const auto h = Hash(input + pos);
+    previous[pos % windowSize] = head[h];
+    head[h] = static_cast<int32_t>(pos);
+  };
+
+  uint32_t pos = 0;
+  while (pos < length) {
+    uint32_t bestLength = 0;
+    uint32_t bestDistance = 0;
+    if (pos + minMatch <= length) {
+      const auto limit = min(maxMatch, length - pos);
+      auto candidate = head[Hash(input + pos)];
+      for (uint32_t chain = 0; candidate != none && chain < maxChain; chain++) {
+        const auto distance = pos - static_cast<uint32_t>(candidate);
+        if (distance > windowSize) break;
+        uint32_t l = 0;
+        while (l < limit && input[candidate + l] == input[pos + l]) l++;
+        if (l > bestLength) {
+          bestLength = l;
+          bestDistance = distance;
+          if (l == limit) break;
+        }
+        const auto next = previous[candidate % windowSize];
+        if (next >= candidate) break; // the slot was reused by a newer position
+        candidate = next;
+      }
+    }
+
+    if (bestLength >= minMatch) {
+      Match(bits, bestLength, bestDistance);
+      for (uint32_t i = 0; i < bestLength; i++, pos++) {
+        if (pos + minMatch <= length) insert(pos);
+      }
+    }
+    else {
+      Literal(bits, input[pos]);
+      if (pos + minMatch <= length) insert(pos);
+      pos++;
+    }
+  }
+  Literal(bits, 256); // end of block
+  bits.Finish();
+  return out;
+}
+
+string Gzip(string_view data) {
+  // magic, deflate, no flags, zero mtime, no extra flags, unknown OS
+  string out{ '\x1f', '\x8b', '\x08', '\0', '\0', '\0', '\0', '\0', '\0', '\xff' };
+  out += Deflate(data);
+  auto append32 = [&out](uint32_t v) {
+    for (int i = 0; i < 4; i++) out.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+  };
+  append32(Crc32(data));
+  append32(static_cast<uint32_t>(data.length()));
+  return out;
+}
+
+worker_pool::worker_pool(size_t count) {
+  count = max<size_t>(count, 1);
+  for (size_t i = 0; i < count; i++) {
+    threads.emplace_back([this]() {
+      for (;;) {
+        function<void()> job;
+        {
+          unique_lock<std::mutex> lock(mutex);
+          wake.wait(lock, [this]() { return stopping || !jobs.empty(); });
+          if (jobs.empty()) return;
+          job = std::move(jobs.front());
+          jobs.pop_front();
+        }
+        job();
+      }
+    });
+  }
+}
+
+worker_pool::~worker_pool() {
+  {
+    lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
+void gzip_siblings::Add(const filesystem::path& file) {
+  // a job still reading the previous contents has to finish before the file is rewritten
+  const auto running = inFlight.find(file);
+  if (running != inFlight.end()) {
+    Collect(running->second);
+    inFlight.erase(running);
+  }
+  queued.insert(file);
+}
+
+void gzip_siblings::Flush() {
+  for (const auto& file : queued) {
+    const auto job = jobs++;
+    inFlight.emplace(file, pool.Submit([file, job]() { return Compress(file, job); }));
+  }
+  queued.clear();
+  // collect what's done so the map doesn't grow with the whole run
+  for (auto f = inFlight.begin(); f != inFlight.end();) {
+    if (f->second.wait_for(chrono::seconds(0)) != future_status::ready) {
+      ++f;
+      continue;
+    }
+    Collect(f->second);
+    f = inFlight.erase(f);
+  }
+}
+
+void gzip_siblings::Wait() {
+  Flush();
+  for (auto& [file, job] : inFlight) {
+    Collect(job);
+  }
+  inFlight.clear();
+}
+
+void gzip_siblings::Collect(future<bool>& job) {
+  (job.get() ? written : kept)++;
+}
+
+bool gzip_siblings::Compress(const filesystem::path& file, size_t job) {
+  string contents;
+  {
+    ifstream in(file, ios::binary);
+    ostringstream buffer;
+    buffer << in.rdbuf();
+    contents = buffer.str();
+  }
+  const auto crc = Crc32(contents);
+  const auto size = static_cast<uint32_t>(contents.length());
+
+  auto gz = file;
+  gz += ".gz";
+  {
+    // a gzip member ends with the CRC-32 and the length of what it decompresses to
+    ifstream existing(gz, ios::binary | ios::ate);
+    if (existing && existing.tellg() >= 18) {
+      unsigned char trailer[8];
+      existing.seekg(-8, ios::end);
+      existing.read(reinterpret_cast<char*>(trailer), sizeof(trailer));
+      auto read32 = [&trailer](int at) { return trailer[at] | (trailer[at + 1] << 8) | (trailer[at + 2] << 16) | (static_cast<uint32_t>(trailer[at + 3]) << 24); };
+      if (existing && read32(0) == crc && read32(4) == size) {
+        return false;
+      }
+    }
+  }
+
+  auto temp = gz;
+  temp += "." + to_string(job) + ".tmp";
+  {
+    ofstream out(temp, ios::binary | ios::trunc);
+    const auto compressed = Gzip(contents);
+    out.write(compressed.data(), compressed.size());
+  }
+  filesystem::rename(temp, gz);
+  return true;
+}
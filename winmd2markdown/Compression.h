@@ -0,0 +1,90 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/// CRC-32 as used by zip and gzip. Pass the previous result as crc to continue a running checksum.
+uint32_t Crc32(std::string_view data, uint32_t crc = 0);
+
+/// <summary>
+/// Raw deflate (RFC 1951) using the fixed Huffman codes and greedy LZ77 matching over a 32 KB window.
+/// Generated docs are repetitive enough that this gets most of the way to zlib's ratio without a dependency.
+/// </summary>
+std::string Deflate(std::string_view data);
+
+/// A complete gzip member (RFC 1952) with a zero timestamp, so the output only depends on data.
+std::string Gzip(std::string_view data);
+
+/// <summary>
+/// Fixed set of threads that compression jobs are handed to. Submit returns a future for the job's result;
+/// callers that need a deterministic output order keep the futures in submission order.
+/// </summary>
+struct worker_pool
+{
+  worker_pool(size_t threads = std::thread::hardware_concurrency());
+  ~worker_pool();
+  worker_pool(const worker_pool&) = delete;
+  worker_pool& operator=(const worker_pool&) = delete;
+
+  template<typename F>
+  auto Submit(F&& job) -> std::future<decltype(job())> {
+    auto task = std::make_shared<std::packaged_task<decltype(job())()>>(std::forward<F>(job));
+    auto result = task->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      jobs.emplace_back([task]() { (*task)(); });
+    }
+    wake.notify_one();
+    return result;
+  }
+
+  size_t Size() const { return threads.size(); }
+
+private:
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::deque<std::function<void()>> jobs;
+  std::vector<std::thread> threads;
+  bool stopping = false;
+};
+
+/// <summary>
+/// Keeps a gzip copy next to each finished output file (/precompress) for static hosts that serve .gz variants.
+/// Files are queued as they're written and handed to the pool at the end of each namespace, so compression overlaps
+/// with rendering the next one. An existing .gz whose trailer already has the file's CRC-32 and size is left alone.
+/// A file can be added again after it was handed out (the flat layout's index is rewritten for every namespace), so
+/// there's at most one job per file, and Add waits for it before the caller rewrites the file.
+/// </summary>
+struct gzip_siblings
+{
+  /// Call before (re)writing the file.
+  void Add(const std::filesystem::path& file);
+  /// Starts compressing everything added since the last call.
+  void Flush();
+  /// Flushes and waits for all the outstanding work.
+  void Wait();
+
+  size_t Written() const { return written; }
+  size_t Kept() const { return kept; }
+
+private:
+  static bool Compress(const std::filesystem::path& file, size_t job);
+  void Collect(std::future<bool>& job);
+
+  worker_pool pool;
+  std::set<std::filesystem::path> queued;
+  std::map<std::filesystem::path, std::future<bool>> inFlight;
+  size_t jobs = 0;
+  size_t written = 0;
+  size_t kept = 0;
+};
@@ -0,0 +1,103 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "ContentStore.h"
+#include "NdJson.h"
+
+using namespace std;
+
+namespace {
+  string ReadFile(const filesystem::path& path) {
+    ifstream in(path, ios::binary);
+    ostringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+  }
+
+  void WriteFile(const filesystem::path& path, string_view contents) {
+    ofstream out(path, ios::binary | ios::trunc);
+    out.write(contents.data(), contents.size());
+    if (!out) {
+      throw runtime_error("Failed to write " + path.u8string());
+    }
+  }
+}
+
+content_store::content_store(filesystem::path directory) : directory(std::move(directory)) {
+  filesystem::create_directories(this->directory);
+}
+
+pair<string_view, string_view> content_store::SplitFrontMatter(string_view page) {
+  // pages written through a text mode stream have CRLF line ends on Windows
+  const string_view newline = page.substr(0, 5) == "---\r\n" ? "\r\n" : "\n";
+  const auto fence = "---" + string(newline);
+  if (page.substr(0, fence.length()) != fence) return { {}, page };
+  const auto end = page.find(string(newline) + fence, fence.length() - newline.length());
+  if (end == string_view::npos) return { {}, page };
+  const auto frontMatter = end + newline.length();
+  return { page.substr(fence.length(), frontMatter - fence.length()), page.substr(frontMatter + fence.length()) };
+}
+
+uint64_t content_store::Hash(string_view data) {
+  // FNV-1a; Store compares the contents before sharing anything, so a collision costs a copy, not a wrong page
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (const auto c : data) {
+    h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+  }
+  return h;
+}
+
+filesystem::path content_store::Store(string_view body) {
+  char name[17];
+  snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(Hash(body)));
+  const auto object = directory / (string(name) + ".md");
+  std::error_code ec;
+  if (filesystem::exists(object, ec)) {
+    if (filesystem::file_size(object) != body.length() || ReadFile(object) != body) return {};
+    shared++;
+    return object;
+  }
+  // written under a temporary name first, so an interrupted run never leaves a truncated object behind
+  const auto temp = directory / (string(name) + ".tmp");
+  WriteFile(temp, body);
+  filesystem::rename(temp, object);
+  stored++;
+  return object;
+}
+
+void content_store::Close(const filesystem::path& frontMatterFile) {
+  vector<string> entries;
+  for (const auto& page : pages) {
+    const auto text = ReadFile(page);
+    const auto [frontMatter, body] = SplitFrontMatter(text);
+    json_record entry;
+    entry.Field("page", page.lexically_relative(frontMatterFile.parent_path()).generic_u8string());
+    size_t start = 0;
+    while (start < frontMatter.length()) {
+      const auto end = frontMatter.find('\n', start);
+      auto line = frontMatter.substr(start, end - start);
+      start = end + 1;
+      if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+      const auto colon = line.find(": ");
+      if (colon != string_view::npos) {
+        entry.Field(line.substr(0, colon), line.substr(colon + 2));
+      }
+    }
+    entries.push_back(entry.str());
+
+    // the page's own file goes away first: writing through it would change every version that links to it
+    filesystem::remove(page);
+    const auto object = Store(body);
+    std::error_code ec;
+    if (!object.empty()) {
+      filesystem::create_hard_link(object, page, ec);
+    }
+    if (object.empty() || ec) {
+      WriteFile(page, body); // a hash collision, or a store on another volume
+    }
+  }
+  ofstream out(frontMatterFile, ios::binary | ios::trunc);
+  out << json_record().Records("pages", entries).str() << "\n";
+  pages.clear();
+}
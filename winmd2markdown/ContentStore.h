@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// <summary>
+/// Shares page bodies between the doc trees of different API versions (/contentStore). Once a run is done, each page's
+/// front matter (the only part that mentions the version) moves into the tree's front-matter.json, and the rest of the
+/// page is stored once in the store under a hash of its contents and hard-linked back into the tree. Pages that didn't
+/// change between versions then take no extra space, and a sync tool that follows hard links uploads them once.
+/// </summary>
+struct content_store
+{
+  content_store(std::filesystem::path directory);
+
+  void Add(const std::filesystem::path& page) { pages.insert(page); }
+  /// Moves every page added into the store and writes their front matter to frontMatterFile.
+  void Close(const std::filesystem::path& frontMatterFile);
+
+  size_t Stored() const { return stored; }
+  size_t Shared() const { return shared; }
+
+  /// Splits a page into its front matter lines ("key: value", without the --- fences) and its body. Lines may end
+  /// in \n or \r\n, as long as the opening fence's does the same.
+  static std::pair<std::string_view, std::string_view> SplitFrontMatter(std::string_view page);
+  static uint64_t Hash(std::string_view data);
+
+private:
+  /// Stores body unless an identical one is there already, and returns where it is; empty if another body has the same hash.
+  std::filesystem::path Store(std::string_view body);
+
+  std::filesystem::path directory;
+  std::set<std::filesystem::path> pages;
+  size_t stored = 0;
+  size_t shared = 0;
+};
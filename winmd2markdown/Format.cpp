@@ -5,13 +5,14 @@
 
 #include "Format.h"
 #include "Program.h"
+#include "TextScan.h"
 
 using namespace std;
 using namespace winmd::reader;
 
 string Formatter::MakeMarkdownReference(const string& ns, const string& type, const string& propertyName) {
   string anchor = type;
-  string link = type;
+  string link = type.empty() ? type : program->ss.GetLinkToType(type);
   if (ns != program->currentNamespace && !ns.empty()) {
     return typeToMarkdown(ns, type + (!propertyName.empty() ? ("." + propertyName) : ""), true);
   }
@@ -41,77 +42,136 @@ string Formatter::MakeXmlReference(const string& ns, const string& type, const s
   return R"(<see cref=")" + (ns.empty() ? program->currentNamespace : ns) + "." + type + ((!type.empty() && !propertyName.empty()) ? "." : "") + propertyName + R"("/>)";
 }
 
+string Formatter::MakeQualifiedReference(const string& ns, const string& type, const string& propertyName) {
+  return (ns.empty() ? program->currentNamespace : ns) + "." + type + ((!type.empty() && !propertyName.empty()) ? "." : "") + propertyName;
+}
+
 std::string code(std::string_view v) {
   return "`" + std::string(v) + "`";
 }
 
 
-string link(string_view n) {
+string link(string_view n, string_view target) {
   //if (IsBuiltInType(n)) return string(n);
-  return "- [" + code(n) + "](" + string(n) + ")";
+  return "- [" + code(n) + "](" + string(target.empty() ? n : target) + ")";
 }
 
-bool isIdentifierChar(char x) {
-  return isalnum(x) || x == '_' || x == '.';
-}
+unescaped_text UnescapeDocText(string_view raw, bool isDocString) {
+  const string_view markers = isDocString ? string_view("\\\r/") : string_view("\\");
+  string out;
+  bool decoded = false;
+  size_t runStart = 0;
+
+  // true when the text at pos decodes to a line feed (raw or escaped); len receives how much input it takes
+  auto isLineFeed = [&](size_t pos, size_t& len) {
+    if (pos < raw.length() && raw[pos] == '\n') { len = 1; return true; }
+    if (pos + 1 < raw.length() && raw[pos] == '\\' && raw[pos + 1] == 'n') { len = 2; return true; }
+    return false;
+  };
+
+  for (size_t pos = raw.find_first_of(markers); pos != string_view::npos; pos = raw.find_first_of(markers, pos)) {
+    string_view replacement;
+    size_t consumed = 0;
+    size_t lf = 0;
+    if (raw[pos] == '\\' && pos + 1 < raw.length() && raw[pos + 1] == 'n') {
+      replacement = "\n";
+      consumed = 2;
+    }
+    else if (isDocString && raw[pos] == '\\' && pos + 1 < raw.length() && raw[pos + 1] == 'r') {
+      const bool crlf = isLineFeed(pos + 2, lf);
+      replacement = crlf ? "\n" : "\r";
+      consumed = 2 + (crlf ? lf : 0);
+    }
+    else if (isDocString && raw[pos] == '\r' && isLineFeed(pos + 1, lf)) {
+      replacement = "\n";
+      consumed = 1 + lf;
+    }
+    else if (isDocString && raw.compare(pos, 3, "/-/") == 0) {
+      replacement = "//";
+      consumed = 3;
+    }
+    else {
+      pos++;
+      continue;
+    }
 
+    if (!decoded) {
+      out.reserve(raw.length());
+      decoded = true;
+    }
+    out.append(raw.data() + runStart, pos - runStart);
+    out.append(replacement);
+    pos += consumed;
+    runStart = pos;
+  }
 
-string Formatter::ResolveReferences(string sane, Converter converter) {
-  stringstream ss;
+  if (!decoded) {
+    return unescaped_text(raw);
+  }
+  out.append(raw.data() + runStart, raw.length() - runStart);
+  return unescaped_text(std::move(out));
+}
 
-  for (size_t input = 0; input < sane.length(); input++) {
-    if (sane[input] == '@') {
-      auto firstNonIdentifier = std::find_if(sane.begin() + input + 1, sane.end(), [](auto& x) { return !isIdentifierChar(x); });
-      if (firstNonIdentifier != sane.begin() && *(firstNonIdentifier - 1) == '.') {
-        firstNonIdentifier--;
-      }
-      auto next = firstNonIdentifier - sane.begin() - 1;
-      auto reference = sane.substr(input + 1, next - input);
-      // The reference could either be a @TypeName.Property
-      // Or it could be a @.Property
-      // Or it could be a @TypeName
-      // So we have to disambiguate whether we are dealing with a type or a property
-      const auto dot = reference.rfind('.');
-      const string prefix = reference.substr(0, dot);
-      const string suffix = (dot != -1) ? reference.substr(dot + 1) : "";
-      TypeDef referredType;
-      if (referredType = program->cache->find(prefix, suffix)) {
-        ss << (this->*converter)(prefix, suffix, "");
-      }
-      else if (suffix.empty() && (referredType = program->cache->find(program->currentNamespace, prefix))) {
-        ss << (this->*converter)(program->currentNamespace, prefix, ""); // typeToMarkdown(referredType.TypeNamespace(), string(referredType.TypeName()), true);
+string Formatter::ResolveReferences(string_view sane, Converter converter) {
+  string ss;
+  ss.reserve(sane.length());
+
+  // Copy the text between references in bulk, jumping from one @ to the next
+  size_t runStart = 0;
+  for (size_t input = FindFirstOf(sane, 0, '@', '@'); input < sane.length(); input = FindFirstOf(sane, runStart, '@', '@')) {
+    ss.append(sane.data() + runStart, input - runStart);
+    auto firstNonIdentifier = SkipIdentifierChars(sane, input + 1);
+    if (sane[firstNonIdentifier - 1] == '.') {
+      firstNonIdentifier--;
+    }
+    const auto next = firstNonIdentifier - 1;
+    const string reference{ sane.substr(input + 1, next - input) };
+    // The reference could either be a @TypeName.Property
+    // Or it could be a @.Property
+    // Or it could be a @TypeName
+    // So we have to disambiguate whether we are dealing with a type or a property
+    const auto dot = reference.rfind('.');
+    const string prefix = reference.substr(0, dot);
+    const string suffix = (dot != -1) ? reference.substr(dot + 1) : "";
+    TypeDef referredType;
+    if (referredType = program->cache->find(prefix, suffix)) {
+      ss += (this->*converter)(prefix, suffix, "");
+    }
+    else if (suffix.empty() && (referredType = program->cache->find(program->currentNamespace, prefix))) {
+      ss += (this->*converter)(program->currentNamespace, prefix, ""); // typeToMarkdown(referredType.TypeNamespace(), string(referredType.TypeName()), true);
+    }
+    else {
+      if (referredType = program->cache->find(program->currentNamespace, prefix)) {
+        // reference is @LocalType.Property
+        ss += (this->*converter)("", prefix, suffix);
       }
       else {
-        if (referredType = program->cache->find(program->currentNamespace, prefix)) {
-          // reference is @LocalType.Property
-          ss << (this->*converter)("", prefix, suffix);
+        const auto dot2 = prefix.rfind('.');
+        if (dot2 != -1 || prefix.empty()) { // either it's a Ns.Type.Prop, or its a .Prop for the current type
+          const string ns = prefix.substr(0, dot2);
+          const string typeName = prefix.substr(dot2 + 1);
+
+          ss += (this->*converter)(ns, typeName, suffix);
+        }
+        else if (!program->xrefs.Find(reference).empty()) {
+          // Ns.Type from a WinMD that isn't loaded, but that an xref map knows
+          ss += (this->*converter)(prefix, suffix, "");
         }
         else {
-          const auto dot2 = prefix.rfind('.');
-          if (dot2 != -1 || prefix.empty()) { // either it's a Ns.Type.Prop, or its a .Prop for the current type
-            const string ns = prefix.substr(0, dot2);
-            const string typeName = prefix.substr(dot2 + 1);
-
-            ss << (this->*converter)(ns, typeName, suffix);
+          if (program->opts->strictReferences) {
+            throw exception(("unknown reference: " + reference).c_str());
           }
           else {
-            if (program->opts->strictReferences) {
-              throw exception(("unknown reference: " + reference).c_str());
-            }
-            else {
-              ss << reference << " (unresolved reference)";
-            }
+            ss += reference + " (unresolved reference)";
           }
         }
       }
-      input = next;
-      continue;
     }
-    ss << sane[input];
+    runStart = next + 1;
   }
+  ss.append(sane.data() + runStart, sane.length() - runStart);
 
-
-  return ss.str();
+  return ss;
 }
 
 std::string Formatter::typeToMarkdown(std::string_view ns, std::string type, bool toCode, string urlSuffix)
@@ -123,9 +183,18 @@ std::string Formatter::typeToMarkdown(std::string_view ns, std::string type, boo
   string code = toCode ? "`" : "";
   if (ns.empty()) return type; // basic type
   else if (ns == program->currentNamespace) {
-    return "[" + code + type + code + "](" + type + ")";
+    return "[" + code + type + code + "](" + program->ss.GetLinkToType(type) + ")";
   }
   else {
+    if (!program->xrefs.Empty()) {
+      // uids name generic types by their arity, e.g. Contoso.Collections.IBag`1, and method overloads as Type.Method*
+      const auto uid = string(ns) + "." + type + (urlSuffix.empty() ? "" : "`" + urlSuffix.substr(1));
+      auto url = program->xrefs.Find(uid);
+      if (url.empty()) url = program->xrefs.Find(uid + "*");
+      if (!url.empty()) {
+        return "[" + code + type + code + "](" + string(url) + ")";
+      }
+    }
     for (const auto& ns_prefix : docs_msft_com_namespaces) {
       if (ns._Starts_with(ns_prefix)) {
         // if it is a Windows type use MSDN, e.g.
@@ -256,6 +325,78 @@ string Formatter::GetType(const TypeSig& type) {
   }
 }
 
+namespace {
+  template<typename Args>
+  string QualifiedGenericName(Formatter& format, string_view ns, string_view name, const Args& args) {
+    string result = string(ns) + "." + string(name.substr(0, name.find('`'))) + "<";
+    bool first = true;
+    for (const auto& a : args) {
+      if (!first) {
+        result += ", ";
+      }
+      first = false;
+      result += format.GetQualifiedType(a);
+    }
+    return result + ">";
+  }
+}
+
+string Formatter::GetQualifiedType(const coded_index<TypeDefOrRef>& tdr) {
+  if (!tdr) return {};
+  switch (tdr.type()) {
+  case TypeDefOrRef::TypeDef:
+  {
+    const auto& td = tdr.TypeDef();
+    return string(td.TypeNamespace()) + "." + string(td.TypeName());
+  }
+  case TypeDefOrRef::TypeRef:
+  {
+    const auto& tr = tdr.TypeRef();
+    return string(tr.TypeNamespace()) + "." + string(tr.TypeName());
+  }
+  case TypeDefOrRef::TypeSpec:
+  {
+    const auto& ts = tdr.TypeSpec();
+    const auto& n = ts.Signature();
+    const auto& s = n.GenericTypeInst();
+    const auto& p = s.GenericType();
+    const auto& tr = p.TypeRef();
+    return QualifiedGenericName(*this, tr.TypeNamespace(), tr.TypeName(), s.GenericArgs());
+  }
+  default:
+    throw std::invalid_argument("");
+  }
+}
+
+string Formatter::GetQualifiedType(const TypeSig::value_type& valueType) {
+  switch (valueType.index())
+  {
+  case 1: // coded_index<TypeDefOrRef>
+    return GetQualifiedType(std::get<coded_index<TypeDefOrRef>>(valueType));
+  case 3: // GenericTypeInstSig
+  {
+    const auto& gt = std::get<GenericTypeInstSig>(valueType);
+    const auto& genericType = gt.GenericType();
+    const auto& tr = genericType.TypeRef();
+    return QualifiedGenericName(*this, tr.TypeNamespace(), tr.TypeName(), gt.GenericArgs());
+  }
+  default:
+    return GetType(valueType);
+  }
+}
+
+string Formatter::GetQualifiedType(const TypeSig& type) {
+  if (type.element_type() != ElementType::Class &&
+    type.element_type() != ElementType::ValueType &&
+    type.element_type() != ElementType::GenericInst
+    ) {
+    return string(ToString(type.element_type()));
+  }
+  else {
+    return GetQualifiedType(type.Type());
+  }
+}
+
 std::string_view Formatter::ToString(ElementType elementType) {
   switch (elementType) {
   case ElementType::Boolean:
@@ -13,8 +13,10 @@ struct Formatter
 
   std::string MakeXmlReference(const std::string& ns, const std::string& type, const std::string& propertyName);
 
+  std::string MakeQualifiedReference(const std::string& ns, const std::string& type, const std::string& propertyName);
+
   using Converter = std::string(Formatter::*)(const std::string& ns, const std::string& typeName, const std::string& propName);
-  std::string ResolveReferences(std::string sane, Converter converter);
+  std::string ResolveReferences(std::string_view sane, Converter converter);
 
   std::string typeToMarkdown(std::string_view ns, std::string type, bool toCode, std::string urlSuffix = "");
 
@@ -27,10 +29,44 @@ struct Formatter
   std::string GetType(const winmd::reader::TypeSig& type);
   std::string GetType(const winmd::reader::TypeSig::value_type& valueType);
 
+  // Namespace-qualified type names without any markdown, e.g. Windows.Foundation.IReference<int> (/emit)
+  std::string GetQualifiedType(const winmd::reader::TypeSig& type);
+  std::string GetQualifiedType(const winmd::reader::TypeSig::value_type& valueType);
+  std::string GetQualifiedType(const winmd::reader::coded_index<winmd::reader::TypeDefOrRef>& tdr);
+
 private:
   Program* program;
 };
 
 std::string code(std::string_view v);
-std::string link(std::string_view n);
+/// A list item linking to n's page, at target if that isn't just n.
+std::string link(std::string_view n, std::string_view target = {});
+
+/// <summary>
+/// Text decoded from a doc attribute. When the attribute value has nothing to unescape it refers directly to the
+/// metadata blob, which stays mapped for the lifetime of the cache; otherwise it owns the decoded copy.
+/// </summary>
+class unescaped_text
+{
+public:
+  unescaped_text() = default;
+  explicit unescaped_text(std::string_view raw) : view(raw) {}
+  explicit unescaped_text(std::string&& decoded) : owned(std::move(decoded)), isOwned(true) {}
+
+  operator std::string_view() const { return isOwned ? std::string_view(owned) : view; }
+  bool empty() const { return static_cast<std::string_view>(*this).empty(); }
+  bool is_copy() const { return isOwned; }
+
+private:
+  std::string_view view;
+  std::string owned;
+  bool isOwned{ false };
+};
+
+/// <summary>
+/// Unescapes a doc attribute value in a single pass. A backslash followed by n always becomes a newline.
+/// For doc strings, backslash-r becomes a carriage return, CR LF pairs collapse to LF and /-/ becomes //
+/// (MIDL doesn't allow // inside IDL strings).
+/// </summary>
+unescaped_text UnescapeDocText(std::string_view raw, bool isDocString);
 
@@ -0,0 +1,348 @@
+#include <cctype>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "Html.h"
+#include "LinkCheck.h"
+
+using namespace std;
+
+namespace {
+  constexpr string_view stylesheet = R"(body { margin: 0; font-family: "Segoe UI", system-ui, sans-serif; line-height: 1.5; color: #1b1b1b; }
+main { max-width: 960px; margin: 0 auto; padding: 1rem 2rem 4rem; }
+h1, h2, h3, h4 { line-height: 1.25; margin-top: 1.5em; }
+a { color: #0065b3; text-decoration: none; }
+a:hover { text-decoration: underline; }
+code { font-family: Consolas, "Cascadia Mono", monospace; font-size: 0.9em; background: #f2f2f2; padding: 0.1em 0.3em; border-radius: 3px; }
+pre { background: #f2f2f2; padding: 0.75em 1em; overflow-x: auto; }
+pre code { padding: 0; background: none; }
+blockquote { margin: 1em 0; padding: 0.25em 1em; border-left: 4px solid #d0d0d0; color: #505050; }
+table { border-collapse: collapse; margin: 1em 0; }
+th, td { border: 1px solid #d0d0d0; padding: 0.3em 0.6em; text-align: left; vertical-align: top; }
+)";
+
+  void Escape(string& out, string_view text) {
+    for (const auto c : text) {
+      switch (c) {
+      case '&': out += "&amp;"; break;
+      case '<': out += "&lt;"; break;
+      case '>': out += "&gt;"; break;
+      case '"': out += "&quot;"; break;
+      default: out += c; break;
+      }
+    }
+  }
+
+  string LinkTarget(string_view target) {
+    const auto page = target.substr(0, target.find('#'));
+    const auto name = page.substr(page.rfind('/') + 1);
+    // anchors on the same page, other sites, and files we don't generate stay as they are
+    if (page.empty() || page.find(':') != string_view::npos || name.find('.') != string_view::npos) return string(target);
+    return string(page) + ".html" + string(target.substr(page.length()));
+  }
+
+  bool StartsWith(string_view text, string_view prefix) {
+    return text.substr(0, prefix.length()) == prefix;
+  }
+
+  void Inline(string& out, string_view text) {
+    bool strong = false;
+    for (size_t i = 0; i < text.length(); i++) {
+      const auto c = text[i];
+      if (c == '`') {
+        const auto end = text.find('`', i + 1);
+        if (end != string_view::npos) {
+          out += "<code>";
+          Escape(out, text.substr(i + 1, end - i - 1));
+          out += "</code>";
+          i = end;
+          continue;
+        }
+      }
+      else if (c == '*' && i + 1 < text.length() && text[i + 1] == '*') {
+        out += strong ? "</strong>" : "<strong>";
+        strong = !strong;
+        i++;
+        continue;
+      }
+      else if (c == '[') {
+        const auto middle = text.find("](", i + 1);
+        const auto end = middle == string_view::npos ? middle : text.find(')', middle + 2);
+        if (end != string_view::npos && text.find(']', i + 1) == middle) {
+          out += "<a href=\"";
+          Escape(out, LinkTarget(text.substr(middle + 2, end - middle - 2)));
+          out += "\">";
+          Inline(out, text.substr(i + 1, middle - i - 1));
+          out += "</a>";
+          i = end;
+          continue;
+        }
+      }
+      else if (c == '<') {
+        // doc strings can have line breaks in them; any other markup is shown as text
+        const auto tag = StartsWith(text.substr(i), "<br/>") ? 5 : StartsWith(text.substr(i), "<br />") ? 6 : 0;
+        if (tag != 0) {
+          out += "<br/>";
+          i += tag - 1;
+          continue;
+        }
+      }
+      else if (c == '\\' && i + 1 < text.length() && ispunct(static_cast<unsigned char>(text[i + 1]))) {
+        i++;
+      }
+      Escape(out, text.substr(i, 1));
+    }
+    if (strong) out += "</strong>";
+  }
+
+  vector<string_view> SplitCells(string_view row) {
+    if (!row.empty() && row.front() == '|') row.remove_prefix(1);
+    if (!row.empty() && row.back() == '|') row.remove_suffix(1);
+    vector<string_view> cells;
+    bool inCode = false;
+    size_t start = 0;
+    for (size_t i = 0; i <= row.length(); i++) {
+      if (i < row.length() && row[i] == '`') inCode = !inCode;
+      if (i == row.length() || (row[i] == '|' && !inCode)) {
+        auto cell = row.substr(start, i - start);
+        while (!cell.empty() && cell.front() == ' ') cell.remove_prefix(1);
+        while (!cell.empty() && cell.back() == ' ') cell.remove_suffix(1);
+        cells.push_back(cell);
+        start = i + 1;
+      }
+    }
+    return cells;
+  }
+
+  string StripCode(string_view text) {
+    string stripped;
+    for (const auto c : text) {
+      if (c != '`') stripped += c;
+    }
+    return stripped;
+  }
+}
+
+string html_site::ToHtml(string_view markdown, string_view stylesheetHref) {
+  string title;
+  if (StartsWith(markdown, "---\n")) {
+    const auto end = markdown.find("\n---", 3);
+    const auto frontMatter = markdown.substr(4, end == string_view::npos ? string_view::npos : end - 3);
+    for (size_t line = 0; line < frontMatter.length(); ) {
+      auto next = frontMatter.find('\n', line);
+      if (next == string_view::npos) next = frontMatter.length();
+      if (StartsWith(frontMatter.substr(line), "title: ")) {
+        title = string(frontMatter.substr(line + 7, next - line - 7));
+      }
+      line = next + 1;
+    }
+    const auto body = end == string_view::npos ? string_view::npos : markdown.find('\n', end + 1);
+    markdown.remove_prefix(body == string_view::npos ? markdown.length() : body + 1);
+  }
+
+  enum class block { none, paragraph, list, quote, table };
+  block open = block::none;
+  bool inCode = false;
+  bool tableSeparator = false;
+  string body;
+  auto close = [&]() {
+    switch (open) {
+    case block::paragraph: body += "</p>\n"; break;
+    case block::list: body += "</ul>\n"; break;
+    case block::quote: body += "</blockquote>\n"; break;
+    case block::table: body += "</tbody>\n</table>\n"; break;
+    default: break;
+    }
+    open = block::none;
+  };
+  auto cells = [&](string_view row, string_view tag) {
+    body += "<tr>";
+    for (const auto& cell : SplitCells(row)) {
+      body += "<" + string(tag) + ">";
+      Inline(body, cell);
+      body += "</" + string(tag) + ">";
+    }
+    body += "</tr>\n";
+  };
+  unordered_map<string, int> seen;
+
+  for (size_t lineStart = 0; lineStart < markdown.length(); ) {
+    auto lineEnd = markdown.find('\n', lineStart);
+    if (lineEnd == string_view::npos) lineEnd = markdown.length();
+    auto line = markdown.substr(lineStart, lineEnd - lineStart);
+    lineStart = lineEnd + 1;
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+    if (inCode) {
+      if (StartsWith(line, "```")) {
+        body += "</code></pre>\n";
+        inCode = false;
+      }
+      else {
+        Escape(body, line);
+        body += '\n';
+      }
+      continue;
+    }
+    if (StartsWith(line, "```")) {
+      close();
+      body += "<pre><code>";
+      inCode = true;
+      continue;
+    }
+    if (line.find_first_not_of(' ') == string_view::npos) {
+      close();
+      continue;
+    }
+
+    const auto level = line.find_first_not_of('#');
+    if (level != 0 && level <= 6 && level != string_view::npos && line[level] == ' ') {
+      close();
+      const auto text = line.substr(level + 1);
+      // the same anchors as the site generator, so links into pages keep working
+      auto slug = link_checker::Slug(StripCode(text));
+      const auto n = seen[slug]++;
+      if (n > 0) slug += "-" + to_string(n);
+      const auto tag = "h" + to_string(level);
+      body += "<" + tag + " id=\"";
+      Escape(body, slug);
+      body += "\">";
+      Inline(body, text);
+      body += "</" + tag + ">\n";
+    }
+    else if (line.front() == '|') {
+      if (open != block::table) {
+        close();
+        body += "<table>\n<thead>\n";
+        cells(line, "th");
+        body += "</thead>\n<tbody>\n";
+        open = block::table;
+        tableSeparator = true;
+      }
+      else if (tableSeparator && line.find_first_not_of("|-: ") == string_view::npos) {
+        tableSeparator = false;
+      }
+      else {
+        tableSeparator = false;
+        cells(line, "td");
+      }
+    }
+    else if (StartsWith(line, "- ") || StartsWith(line, "* ")) {
+      if (open != block::list) {
+        close();
+        body += "<ul>\n";
+        open = block::list;
+      }
+      body += "<li>";
+      Inline(body, line.substr(2));
+      body += "</li>\n";
+    }
+    else if (line.front() == '>') {
+      auto text = line.substr(1);
+      if (!text.empty() && text.front() == ' ') text.remove_prefix(1);
+      if (open != block::quote) {
+        close();
+        body += "<blockquote>";
+        open = block::quote;
+      }
+      else {
+        body += "<br/>\n";
+      }
+      Inline(body, text);
+    }
+    else {
+      if (open != block::paragraph) {
+        close();
+        body += "<p>";
+        open = block::paragraph;
+      }
+      else {
+        body += '\n';
+      }
+      Inline(body, line);
+    }
+  }
+  close();
+  if (inCode) {
+    body += "</code></pre>\n";
+  }
+
+  string page = "<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n<title>";
+  Escape(page, title);
+  page += "</title>\n<link rel=\"stylesheet\" href=\"";
+  Escape(page, stylesheetHref);
+  page += "\">\n</head>\n<body>\n<main>\n";
+  if (!title.empty()) {
+    page += "<h1>";
+    Escape(page, title);
+    page += "</h1>\n";
+  }
+  return page + body + "</main>\n</body>\n</html>\n";
+}
+
+filesystem::path html_site::HtmlPath(const filesystem::path& path) const {
+  auto stem = path.stem().u8string();
+  if (!fileSuffix.empty() && stem.length() > fileSuffix.length() && stem.compare(stem.length() - fileSuffix.length(), fileSuffix.length(), fileSuffix) == 0) {
+    stem.resize(stem.length() - fileSuffix.length());
+  }
+  return path.parent_path() / filesystem::u8path(stem + ".html");
+}
+
+shared_ptr<ostream> html_site::Open(const filesystem::path& path, bool append) {
+  auto& page = pending[path];
+  if (!page || !append) {
+    page = make_shared<ostringstream>();
+  }
+  return page;
+}
+
+void html_site::Flush() {
+  for (auto& [path, page] : pending) {
+    string href;
+    for (const auto& part : path.parent_path().lexically_relative(outputDirectory)) {
+      if (part != ".") href += "../";
+    }
+    href += stylesheetName;
+    const auto target = HtmlPath(path);
+    auto& job = inFlight[target];
+    if (job.valid()) {
+      // an earlier version of the page is still being written
+      job.get();
+      written++;
+    }
+    job = pool.Submit([target, page = std::move(page), href]() {
+      Write(target, ToHtml(page->str(), href));
+    });
+  }
+  pending.clear();
+  // collect what's done so the map doesn't grow with the whole run
+  for (auto f = inFlight.begin(); f != inFlight.end();) {
+    if (f->second.wait_for(chrono::seconds(0)) != future_status::ready) {
+      ++f;
+      continue;
+    }
+    f->second.get();
+    f = inFlight.erase(f);
+    written++;
+  }
+}
+
+void html_site::Wait() {
+  Flush();
+  for (auto& [target, job] : inFlight) {
+    job.get();
+    written++;
+  }
+  inFlight.clear();
+  Write(outputDirectory / filesystem::u8path(stylesheetName), stylesheet);
+}
+
+void html_site::Write(const filesystem::path& path, string_view contents) {
+  ofstream out(path, ios::binary | ios::trunc);
+  out.write(contents.data(), contents.length());
+  if (!out) {
+    throw runtime_error("Failed to write " + path.u8string());
+  }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <filesystem>
+#include <future>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "Compression.h"
+
+/// <summary>
+/// Writes the pages as static HTML instead of markdown (/html), so a site doesn't need a markdown build. The pages
+/// are rendered to markdown in memory as usual; at the end of each namespace, once its "Referenced by" sections are
+/// in, they're handed to the pool to be converted and written, which overlaps with rendering the next namespace.
+/// A page opened again in a later namespace (the flat layout's index) waits for its previous write, so the last
+/// version is the one that stays. Every page links to one stylesheet at the root of the output directory. Links between pages get an .html
+/// extension, and headings get the same anchors as on the markdown site.
+/// </summary>
+struct html_site
+{
+  static constexpr std::string_view stylesheetName = "winmd2md.css";
+
+  html_site(std::filesystem::path outputDirectory, std::string fileSuffix) : outputDirectory(std::move(outputDirectory)), fileSuffix(std::move(fileSuffix)) {}
+
+  /// The markdown of a page; path is where the .md file would go.
+  std::shared_ptr<std::ostream> Open(const std::filesystem::path& path, bool append);
+  /// Starts converting every page opened since the last call.
+  void Flush();
+  /// Flushes, waits for the outstanding pages and writes the stylesheet.
+  void Wait();
+
+  size_t Written() const { return written; }
+
+  /// A complete page for the markdown the tool generates: front matter, headings, paragraphs, lists, quotes, tables,
+  /// code blocks, and inline code, bold text and links.
+  static std::string ToHtml(std::string_view markdown, std::string_view stylesheet);
+  /// page.md becomes page.html, without the /fileSuffix, since that's the name other pages link to.
+  std::filesystem::path HtmlPath(const std::filesystem::path& path) const;
+
+private:
+  static void Write(const std::filesystem::path& path, std::string_view contents);
+
+  std::filesystem::path outputDirectory;
+  std::string fileSuffix;
+  worker_pool pool;
+  std::map<std::filesystem::path, std::shared_ptr<std::ostringstream>> pending;
+  // by the .html file being written
+  std::map<std::filesystem::path, std::future<void>> inFlight;
+  size_t written = 0;
+};
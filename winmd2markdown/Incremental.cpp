@@ -0,0 +1,153 @@
+#include <fstream>
+#include <sstream>
+
+#include "Incremental.h"
+
+using namespace std;
+
+namespace {
+  constexpr string_view header = "winmd2md-state 1";
+
+  uint64_t Hash(uint64_t h, string_view data) {
+    for (const auto c : data) {
+      h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+    }
+    return (h ^ 0xff) * 0x100000001b3ull;
+  }
+
+  string NamespaceOf(const string& qualifiedName) {
+    const auto dot = qualifiedName.rfind('.');
+    return dot == string::npos ? string() : qualifiedName.substr(0, dot);
+  }
+}
+
+void incremental_state::Add(const model_record& record) {
+  auto& type = types[string(record.ns) + "." + string(record.type)];
+  auto h = type.hash == 0 ? 0xcbf29ce484222325ull : type.hash;
+  h = Hash(h, ToString(record.kind));
+  h = Hash(h, record.member);
+  h = Hash(h, record.valueType);
+  h = Hash(h, record.signature);
+  for (const auto& i : record.implements) {
+    h = Hash(h, i);
+  }
+  for (const auto& p : record.parameters) {
+    h = Hash(Hash(h, p.name), p.out ? "out " + p.type : p.type);
+  }
+  h = Hash(h, string{ record.isStatic ? 's' : '-', record.readonly ? 'r' : '-', record.experimental ? 'x' : '-' });
+  h = Hash(h, to_string(record.value));
+  h = Hash(h, record.deprecated);
+  h = Hash(h, record.defaultValue);
+  type.hash = Hash(h, record.doc);
+}
+
+incremental_state incremental_state::Load(const filesystem::path& file) {
+  incremental_state state;
+  ifstream in(file);
+  string line;
+  if (!getline(in, line) || line.compare(0, header.length(), header) != 0) return {};
+  state.fingerprint = line.length() > header.length() ? line.substr(header.length() + 1) : "";
+  type_state* current = nullptr;
+  while (getline(in, line)) {
+    if (line.length() < 2 || line[1] != ' ') continue;
+    const auto value = line.substr(2);
+    switch (line[0]) {
+    case 'T': {
+      const auto space = value.rfind(' ');
+      if (space == string::npos) return {};
+      current = &state.types[value.substr(0, space)];
+      current->hash = stoull(value.substr(space + 1), nullptr, 16);
+      break;
+    }
+    case 'R':
+      if (current) current->referrers.push_back(value);
+      break;
+    case 'I':
+      if (current) current->implementers.push_back(value);
+      break;
+    }
+  }
+  return state;
+}
+
+void incremental_state::Save(const filesystem::path& file) const {
+  auto temp = file;
+  temp += ".tmp";
+  {
+    ofstream out(temp, ios::trunc);
+    out << header << " " << fingerprint << "\n";
+    for (const auto& [name, type] : types) {
+      out << "T " << name << " " << hex << type.hash << dec << "\n";
+      for (const auto& r : type.referrers) {
+        out << "R " << r << "\n";
+      }
+      for (const auto& i : type.implementers) {
+        out << "I " << i << "\n";
+      }
+    }
+    if (!out) {
+      throw runtime_error("Failed to write " + temp.u8string());
+    }
+  }
+  filesystem::rename(temp, file);
+}
+
+incremental_plan incremental_plan::Make(const incremental_state& previous, const incremental_state& current) {
+  incremental_plan plan;
+  const bool comparable = previous.fingerprint == current.fingerprint;
+  set<string> changed;
+  for (const auto& [name, type] : current.types) {
+    const auto before = comparable ? previous.types.find(name) : previous.types.end();
+    if (before == previous.types.end()) {
+      plan.indexes.insert(NamespaceOf(name));
+      changed.insert(name);
+    }
+    else if (before->second.hash != type.hash) {
+      changed.insert(name);
+    }
+    else if (before->second.referrers != type.referrers || before->second.implementers != type.implementers) {
+      plan.pages.insert(name);
+    }
+  }
+  // even when the options changed, the pages of types that are gone still have to go
+  for (const auto& [name, type] : previous.types) {
+    if (current.types.find(name) == current.types.end()) {
+      plan.removed.push_back(name);
+      plan.indexes.insert(NamespaceOf(name));
+      changed.insert(name);
+    }
+  }
+
+  // pages that render a changed type's name, as it is now or as it was
+  auto addDependents = [&](const incremental_state& state, const string& name) {
+    const auto type = state.types.find(name);
+    if (type == state.types.end()) return;
+    for (const auto* dependents : { &type->second.referrers, &type->second.implementers }) {
+      for (const auto& d : *dependents) {
+        if (current.types.find(d) != current.types.end()) {
+          plan.pages.insert(d);
+        }
+      }
+    }
+  };
+  for (const auto& name : changed) {
+    if (current.types.find(name) != current.types.end()) {
+      plan.pages.insert(name);
+    }
+    addDependents(current, name);
+    if (comparable) {
+      addDependents(previous, name);
+    }
+  }
+  plan.skipped = current.types.size() - plan.pages.size();
+  return plan;
+}
+
+bool incremental_plan::Touches(const string& ns) const {
+  if (indexes.find(ns) != indexes.end()) return true;
+  const auto prefix = ns + ".";
+  for (auto it = pages.lower_bound(prefix); it != pages.end() && it->compare(0, prefix.length(), prefix) == 0; ++it) {
+    if (it->find('.', prefix.length()) == string::npos) return true; // not a type of a nested namespace
+  }
+  return false;
+}
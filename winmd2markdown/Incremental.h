@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Model.h"
+
+/// <summary>
+/// What a run of /incremental remembers about each page: a hash of everything rendered on it (the model records of
+/// the type and its members, docs included) and the types that point back at it through its "Referenced by" and
+/// "Implemented by" lists. Comparing this with the previous run's tells which pages have to be written again.
+/// </summary>
+struct incremental_state
+{
+  struct type_state {
+    uint64_t hash = 0;
+    /// Qualified names, sorted
+    std::vector<std::string> referrers;
+    std::vector<std::string> implementers;
+  };
+
+  /// fingerprint identifies the options that change how pages look; states with different ones share nothing.
+  incremental_state(std::string fingerprint = {}) : fingerprint(std::move(fingerprint)) {}
+
+  void Add(const model_record& record);
+
+  /// Returns an empty state if the file is missing or was written by another version.
+  static incremental_state Load(const std::filesystem::path& file);
+  void Save(const std::filesystem::path& file) const;
+
+  std::string fingerprint;
+  /// Keyed by Namespace.Type
+  std::map<std::string, type_state> types;
+};
+
+/// <summary>
+/// The pages an incremental run writes: the types whose own content changed, the types whose back-reference lists
+/// changed, the pages that name a changed or removed type (its referrers and implementers, before and after), and
+/// the index of every namespace that gained or lost a type.
+/// </summary>
+struct incremental_plan
+{
+  static incremental_plan Make(const incremental_state& previous, const incremental_state& current);
+
+  bool Touches(const std::string& ns) const;
+
+  /// Qualified names
+  std::set<std::string> pages;
+  std::set<std::string> indexes;
+  std::vector<std::string> removed;
+  size_t skipped = 0;
+};
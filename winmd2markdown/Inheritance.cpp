@@ -0,0 +1,82 @@
+#include <algorithm>
+
+#include "Inheritance.h"
+
+using namespace std;
+
+shared_ptr<const inheritance_node> inheritance_graph::Get(string_view name) {
+  const auto found = nodes.find(name);
+  if (found != nodes.end()) return found->second;
+  if (resolving.find(name) != resolving.end()) return nullptr;
+
+  auto info = resolve(name);
+  if (!info) {
+    nodes.emplace(name, nullptr);
+    return nullptr;
+  }
+  resolving.emplace(name);
+  auto node = make_shared<inheritance_node>();
+  node->name = string(name);
+  node->declared = std::move(info->declared);
+  sort(node->declared.begin(), node->declared.end(), [](const inherited_member& a, const inherited_member& b) { return a.name < b.name; });
+  for (const auto& base : info->bases) {
+    if (auto b = Get(base)) {
+      node->bases.push_back(std::move(b));
+    }
+  }
+  resolving.erase(resolving.find(name));
+  nodes.emplace(name, node);
+  return node;
+}
+
+inheritance_graph::groups inheritance_graph::Inherited(string_view name) {
+  const auto node = Get(name);
+  if (!node) return make_shared<const vector<group>>();
+  return Flatten(*node);
+}
+
+inheritance_graph::groups inheritance_graph::Flatten(const inheritance_node& node) {
+  auto& memo = flattened[&node];
+  if (memo) return memo;
+
+  // breadth first, so that a member hidden by a closer ancestor is listed for that ancestor only: the bases, then
+  // what each base inherits one level further out, in the order of the bases within a level
+  vector<group> candidates;
+  for (const auto& b : node.bases) {
+    auto declared = make_shared<vector<const inherited_member*>>();
+    for (const auto& m : b->declared) {
+      declared->push_back(&m);
+    }
+    candidates.push_back({ b->name, 1, std::move(declared) });
+  }
+  for (const auto& b : node.bases) {
+    for (const auto& g : *Flatten(*b)) {
+      candidates.push_back({ g.type, g.depth + 1, g.members });
+    }
+  }
+  stable_sort(candidates.begin(), candidates.end(), [](const group& a, const group& b) { return a.depth < b.depth; });
+
+  auto result = make_shared<vector<group>>();
+  set<pair<model_kind, string_view>> seen;
+  for (const auto& m : node.declared) {
+    seen.emplace(m.kind, m.name);
+  }
+  set<string_view> visited;
+  for (auto& c : candidates) {
+    // an ancestor reached through several bases is listed for the nearest one
+    if (!visited.insert(c.type).second) continue;
+    vector<const inherited_member*> kept;
+    for (const auto* m : *c.members) {
+      if (seen.emplace(m->kind, m->name).second) {
+        kept.push_back(m);
+      }
+    }
+    if (kept.empty()) continue;
+    if (kept.size() != c.members->size()) {
+      c.members = make_shared<const vector<const inherited_member*>>(std::move(kept));
+    }
+    result->push_back(std::move(c));
+  }
+  memo = std::move(result);
+  return memo;
+}
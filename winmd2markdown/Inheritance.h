@@ -0,0 +1,76 @@
+#pragma once
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Model.h"
+
+struct inherited_member
+{
+  model_kind kind;
+  std::string name;
+};
+
+/// <summary>
+/// A type in the inheritance graph: the members it declares, and the nodes of the types it inherits from (the base
+/// class first, then the implemented or required interfaces). Nodes are immutable and shared, so every type derived
+/// from a base points at the one node built for it.
+/// </summary>
+struct inheritance_node
+{
+  std::string name;
+  /// Sorted by name
+  std::vector<inherited_member> declared;
+  std::vector<std::shared_ptr<const inheritance_node>> bases;
+};
+
+/// <summary>
+/// The members a type inherits from its base classes and required interfaces (/inheritedMembers). Each type is
+/// resolved once, the first time it or a type deriving from it is asked for, and its node is then shared by all the
+/// types deriving from it. A type's inherited members are worked out once too, from its bases' lists rather than by
+/// walking its ancestors again, and a group that no closer declaration hides is shared with the bases' lists. So a
+/// type costs about as much as its own list is long, whatever the depth of the hierarchy.
+/// </summary>
+struct inheritance_graph
+{
+  struct type_info {
+    std::vector<inherited_member> declared;
+    /// Namespace.Type names
+    std::vector<std::string> bases;
+  };
+  /// Returns what a Namespace.Type declares and inherits from, or nothing when the type isn't known (e.g. it comes
+  /// from a WinMD that wasn't loaded).
+  using resolver = std::function<std::optional<type_info>(std::string_view name)>;
+
+  /// The members inherited from one ancestor, which the type and its closer ancestors don't declare themselves
+  struct group {
+    std::string_view type;
+    /// 1 for a direct base, 2 for the bases of those, and so on
+    size_t depth;
+    std::shared_ptr<const std::vector<const inherited_member*>> members;
+  };
+  using groups = std::shared_ptr<const std::vector<group>>;
+
+  inheritance_graph(resolver resolve) : resolve(std::move(resolve)) {}
+
+  /// nullptr when the type isn't known
+  std::shared_ptr<const inheritance_node> Get(std::string_view name);
+  /// The type's inherited members, grouped by the ancestor that declares them, nearest first. Never nullptr.
+  groups Inherited(std::string_view name);
+  size_t Resolved() const { return nodes.size(); }
+
+private:
+  groups Flatten(const inheritance_node& node);
+
+  resolver resolve;
+  std::map<std::string, std::shared_ptr<const inheritance_node>, std::less<>> nodes;
+  /// What Flatten worked out for each node
+  std::map<const inheritance_node*, groups> flattened;
+  /// Types being resolved, to break cycles in malformed metadata
+  std::set<std::string, std::less<>> resolving;
+};
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cctype>
+#include <future>
+
+#include "Compression.h"
+#include "LinkCheck.h"
+
+using namespace std;
+
+namespace {
+  constexpr string_view unresolvedSuffix = " (unresolved reference)";
+
+  string StripCode(string_view text) {
+    string stripped;
+    for (const auto c : text) {
+      if (c != '`') stripped += c;
+    }
+    return stripped;
+  }
+}
+
+string link_checker::Slug(string_view heading) {
+  string slug;
+  for (const auto c : heading) {
+    const auto u = static_cast<unsigned char>(c);
+    if (isalnum(u)) slug += static_cast<char>(tolower(u));
+    else if (c == ' ') slug += '-';
+    else if (c == '-' || c == '_' || u >= 0x80) slug += c;
+  }
+  return slug;
+}
+
+void link_checker::AddPage(string_view page, string_view markdown) {
+  const string pageName(page);
+  anchors.insert(pageName);
+  unordered_map<string, int> seen;
+  string member;
+  bool inCode = false;
+
+  size_t lineStart = 0;
+  while (lineStart < markdown.length()) {
+    auto lineEnd = markdown.find('\n', lineStart);
+    if (lineEnd == string_view::npos) lineEnd = markdown.length();
+    const auto line = markdown.substr(lineStart, lineEnd - lineStart);
+    lineStart = lineEnd + 1;
+
+    if (line.compare(0, 3, "```") == 0) {
+      inCode = !inCode;
+      continue;
+    }
+    if (inCode) continue;
+
+    const auto level = line.find_first_not_of('#');
+    if (level != 0 && level != string_view::npos && line[level] == ' ') {
+      // repeated headings get -1, -2... like the site generator does
+      member = StripCode(line.substr(level + 1));
+      auto slug = Slug(member);
+      const auto n = seen[slug]++;
+      if (n > 0) slug += "-" + to_string(n);
+      anchors.insert(pageName + "#" + slug);
+      continue;
+    }
+
+    for (auto at = line.find("]("); at != string_view::npos; at = line.find("](", at + 2)) {
+      const auto end = line.find(')', at + 2);
+      if (end == string_view::npos) break;
+      auto target = line.substr(at + 2, end - at - 2);
+      auto pagePart = target.substr(0, target.find('#'));
+      if (pagePart.find(':') != string_view::npos) continue; // another site
+      if (const auto slash = pagePart.rfind('/'); slash != string_view::npos) {
+        // a page in another directory (/fanOut); pages are known by type name
+        target.remove_prefix(slash + 1);
+        pagePart.remove_prefix(slash + 1);
+      }
+      if (pagePart.find('.') != string_view::npos) continue; // a file we don't generate
+      links.push_back({ pageName, member, target[0] == '#' ? pageName + string(target) : string(target), false });
+    }
+    for (auto at = line.find(unresolvedSuffix); at != string_view::npos; at = line.find(unresolvedSuffix, at + 1)) {
+      const auto start = line.find_last_of(" \t(", at == 0 ? 0 : at - 1);
+      const auto from = start == string_view::npos ? 0 : start + 1;
+      links.push_back({ pageName, member, string(line.substr(from, at - from)), true });
+    }
+  }
+}
+
+void link_checker::AddLink(string_view page, string_view member, string_view target) {
+  links.push_back({ string(page), string(member), string(target), false });
+}
+
+vector<link_checker::broken_link> link_checker::Check() const {
+  worker_pool pool;
+  const size_t chunk = max<size_t>(1, (links.size() + pool.Size() - 1) / pool.Size());
+  vector<future<vector<broken_link>>> results;
+  for (size_t first = 0; first < links.size(); first += chunk) {
+    results.push_back(pool.Submit([this, first, last = min(links.size(), first + chunk)]() {
+      vector<broken_link> broken;
+      for (size_t i = first; i < last; i++) {
+        const auto& l = links[i];
+        if (l.unresolved) {
+          broken.push_back({ l.page, l.member, l.target, "unresolved reference" });
+        }
+        else if (anchors.find(l.target) == anchors.end()) {
+          const auto hash = l.target.find('#');
+          const bool pageExists = hash != string::npos && anchors.find(l.target.substr(0, hash)) != anchors.end();
+          broken.push_back({ l.page, l.member, l.target, pageExists ? "no such anchor" : "no such page" });
+        }
+      }
+      return broken;
+    }));
+  }
+  vector<broken_link> broken;
+  for (auto& r : results) {
+    for (auto& b : r.get()) {
+      broken.push_back(std::move(b));
+    }
+  }
+  return broken;
+}
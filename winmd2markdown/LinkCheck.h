@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/// <summary>
+/// Checks the links between the generated pages (/checkLinks). Each page is scanned once when it's finished: its
+/// headings become anchors, and its relative links and unresolved @references are recorded along with the page and
+/// heading they appear under. Check then looks every link up against the anchors on a worker pool.
+/// Links to other sites aren't checked.
+/// </summary>
+struct link_checker
+{
+  /// Records the anchors and links in the markdown of a rendered page.
+  void AddPage(std::string_view page, std::string_view markdown);
+  /// Records a link written outside a page's body, e.g. from an index or a "Referenced by" section.
+  void AddLink(std::string_view page, std::string_view member, std::string_view target);
+
+  struct broken_link {
+    std::string page;
+    std::string member;
+    std::string target;
+    std::string reason;
+  };
+  std::vector<broken_link> Check() const;
+
+  size_t LinkCount() const { return links.size(); }
+
+  /// The anchor a heading gets: lower case, punctuation dropped, spaces turned into dashes.
+  static std::string Slug(std::string_view heading);
+
+private:
+  struct link {
+    std::string page;
+    std::string member;
+    std::string target;
+    bool unresolved;
+  };
+
+  std::unordered_set<std::string> anchors;
+  std::vector<link> links;
+};
@@ -0,0 +1,46 @@
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+#include <stdexcept>
+
+#include "MappedFile.h"
+
+using namespace std;
+
+mapped_file::mapped_file(const filesystem::path& file) {
+  auto fail = [&file](const char* why) {
+    return std::runtime_error(file.u8string() + ": " + why);
+  };
+  size = filesystem::file_size(file);
+  if (size == 0) {
+    return; // there's nothing to map, and CreateFileMapping refuses empty files
+  }
+
+  fileHandle = CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (fileHandle == INVALID_HANDLE_VALUE) {
+    fileHandle = nullptr;
+    throw fail("couldn't open the file");
+  }
+  mapping = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping) {
+    data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+  }
+  if (!data) {
+    Unmap();
+    throw fail("couldn't map the file");
+  }
+}
+
+mapped_file::~mapped_file() {
+  Unmap();
+}
+
+void mapped_file::Unmap() {
+  if (data) UnmapViewOfFile(data);
+  if (mapping) CloseHandle(mapping);
+  if (fileHandle) CloseHandle(fileHandle);
+  data = nullptr;
+  mapping = nullptr;
+  fileHandle = nullptr;
+}
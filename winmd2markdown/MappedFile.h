@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+/// <summary>
+/// A file mapped read-only into memory (/extractBundle, /fromSnapshot). Contents() points into the mapping, so it's
+/// only valid while the mapped_file is alive. An empty file has empty contents.
+/// </summary>
+struct mapped_file
+{
+  mapped_file(const std::filesystem::path& file);
+  ~mapped_file();
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  std::string_view Contents() const { return { data, static_cast<size_t>(size) }; }
+
+private:
+  void Unmap();
+
+  void* fileHandle = nullptr;
+  void* mapping = nullptr;
+  const char* data = nullptr;
+  uint64_t size = 0;
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// What a model record describes. Snapshots store these values, so new kinds go at the end.
+enum class model_kind : uint32_t
+{
+  Class,
+  Interface,
+  Enum,
+  Struct,
+  Delegate,
+  Property,
+  Constructor,
+  Method,
+  Event,
+  Field,
+  EnumValue,
+};
+
+inline bool IsType(model_kind kind) {
+  return kind <= model_kind::Delegate;
+}
+
+inline std::string_view ToString(model_kind kind) {
+  constexpr std::string_view names[] = { "class", "interface", "enum", "struct", "delegate", "property", "constructor", "method", "event", "field", "enumValue" };
+  return names[static_cast<uint32_t>(kind)];
+}
+
+struct model_parameter
+{
+  std::string name;
+  std::string type;
+  bool out{ false };
+};
+
+/// <summary>
+/// A type or member of the resolved documentation model, built from the same data its page is rendered from
+/// (/emit, /outputSnapshot). Type names are namespace-qualified and free of markdown, and references in the doc
+/// text are resolved to qualified names.
+/// </summary>
+struct model_record
+{
+  model_kind kind{ model_kind::Class };
+  std::string_view ns;
+  std::string_view type;
+  /// Empty for types
+  std::string_view member;
+  /// The base class of a type, the type of a property, field or event, or the return type of a method
+  std::string valueType;
+  /// Plain-text declaration of a member, e.g. "static int Add(int a, out int b)"
+  std::string signature;
+  std::vector<std::string> implements;
+  std::vector<model_parameter> parameters;
+  bool isStatic{ false };
+  bool readonly{ false };
+  bool experimental{ false };
+  int64_t value{ 0 };
+  std::string deprecated;
+  std::string defaultValue;
+  std::string doc;
+};
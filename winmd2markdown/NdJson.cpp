@@ -0,0 +1,137 @@
+#include "NdJson.h"
+
+using namespace std;
+
+void json_record::Escape(string& out, string_view value) {
+  constexpr char hex[] = "0123456789abcdef";
+  out += '"';
+  size_t runStart = 0;
+  for (size_t i = 0; i < value.length(); i++) {
+    const auto c = static_cast<unsigned char>(value[i]);
+    if (c >= 0x20 && c != '"' && c != '\\') continue;
+    out.append(value.data() + runStart, i - runStart);
+    runStart = i + 1;
+    switch (c) {
+    case '"': out += "\\\""; break;
+    case '\\': out += "\\\\"; break;
+    case '\n': out += "\\n"; break;
+    case '\r': out += "\\r"; break;
+    case '\t': out += "\\t"; break;
+    default:
+      out += "\\u00";
+      out += hex[c >> 4];
+      out += hex[c & 0xf];
+      break;
+    }
+  }
+  out.append(value.data() + runStart, value.length() - runStart);
+  out += '"';
+}
+
+json_record& json_record::Key(string_view key) {
+  if (text.length() > 1) {
+    text += ',';
+  }
+  Escape(text, key);
+  text += ':';
+  return *this;
+}
+
+json_record& json_record::Field(string_view key, string_view value) {
+  Key(key);
+  Escape(text, value);
+  return *this;
+}
+
+json_record& json_record::Field(string_view key, bool value) {
+  Key(key);
+  text += value ? "true" : "false";
+  return *this;
+}
+
+json_record& json_record::Field(string_view key, int64_t value) {
+  Key(key);
+  text += to_string(value);
+  return *this;
+}
+
+json_record& json_record::Field(string_view key, const vector<string>& values) {
+  Key(key);
+  text += '[';
+  for (size_t i = 0; i < values.size(); i++) {
+    if (i != 0) text += ',';
+    Escape(text, values[i]);
+  }
+  text += ']';
+  return *this;
+}
+
+json_record& json_record::OptionalField(string_view key, string_view value) {
+  if (value.empty()) {
+    Key(key);
+    text += "null";
+    return *this;
+  }
+  return Field(key, value);
+}
+
+json_record& json_record::Records(string_view key, const vector<string>& records) {
+  Key(key);
+  text += '[';
+  for (size_t i = 0; i < records.size(); i++) {
+    if (i != 0) text += ',';
+    text += records[i];
+  }
+  text += ']';
+  return *this;
+}
+
+void ndjson_writer::Write(const model_record& record) {
+  json_record json;
+  json.Field("kind", ToString(record.kind)).Field("namespace", record.ns).Field("type", record.type);
+  if (!record.member.empty()) {
+    json.Field("member", record.member);
+  }
+  switch (record.kind) {
+  case model_kind::Class:
+  case model_kind::Interface:
+    json.OptionalField("extends", record.valueType).Field("implements", record.implements);
+    break;
+  case model_kind::Property:
+    json.Field("propertyType", record.valueType).Field("static", record.isStatic).Field("readonly", record.readonly);
+    break;
+  case model_kind::Constructor:
+  case model_kind::Method: {
+    vector<string> parameters;
+    for (const auto& p : record.parameters) {
+      parameters.push_back(json_record().Field("name", p.name).Field("type", p.type).Field("out", p.out).str());
+    }
+    json.OptionalField("returnType", record.valueType).Field("static", record.isStatic).Records("parameters", parameters);
+    break;
+  }
+  case model_kind::Event:
+    json.Field("eventType", record.valueType);
+    break;
+  case model_kind::Field:
+    json.Field("fieldType", record.valueType);
+    break;
+  case model_kind::EnumValue:
+    json.Field("value", record.value);
+    break;
+  default:
+    break;
+  }
+  if (!IsType(record.kind)) {
+    json.Field("signature", record.signature);
+  }
+  json.Field("experimental", record.experimental)
+    .OptionalField("deprecated", record.deprecated)
+    .OptionalField("default", record.defaultValue)
+    .OptionalField("doc", record.doc);
+  Write(json);
+}
+
+void ndjson_writer::Write(const json_record& record) {
+  *out << record.str() << '\n';
+  count++;
+}
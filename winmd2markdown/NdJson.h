@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Model.h"
+
+/// <summary>
+/// One JSON object, built field by field in the order the fields are added. Values are written as they're added,
+/// so a record costs one string no matter how it's put together.
+/// </summary>
+struct json_record
+{
+  json_record& Field(std::string_view key, std::string_view value);
+  json_record& Field(std::string_view key, const char* value) { return Field(key, std::string_view(value)); }
+  json_record& Field(std::string_view key, bool value);
+  json_record& Field(std::string_view key, int64_t value);
+  json_record& Field(std::string_view key, const std::vector<std::string>& values);
+  /// Adds the field as a string, or as null when value is empty.
+  json_record& OptionalField(std::string_view key, std::string_view value);
+  /// Adds an array of objects. Each element is a finished record, as returned by str().
+  json_record& Records(std::string_view key, const std::vector<std::string>& records);
+
+  /// The finished object, without a trailing newline.
+  std::string str() const { return text + "}"; }
+
+  static void Escape(std::string& out, std::string_view value);
+
+private:
+  json_record& Key(std::string_view key);
+  std::string text{ "{" };
+};
+
+/// <summary>
+/// Writes the documentation model as newline-delimited JSON (/emit ndjson): one record per type and per member, in
+/// the order they're rendered. Nothing is kept once a record is written, and the stream is flushed after each type,
+/// so a consumer reading the other end of a pipe sees each type as soon as its page is done.
+/// </summary>
+struct ndjson_writer
+{
+  ndjson_writer(std::shared_ptr<std::ostream> out) : out(std::move(out)) {}
+
+  void Write(const json_record& record);
+  void Write(const model_record& record);
+  void Flush() { out->flush(); }
+  size_t Count() const { return count; }
+
+private:
+  std::shared_ptr<std::ostream> out;
+  size_t count = 0;
+};
@@ -2,6 +2,7 @@
 
 #define BOOL_SWITCH_SETTER(x)   0, [](options* o, std::string ) { o->x = true; }
 #define STRING_SWITCH_SETTER(x) 1, [](options*o, std::string value) { o->x = value; }
+#define LIST_SWITCH_SETTER(x)   1, [](options*o, std::string value) { o->x += (o->x.empty() ? "" : ";") + value; }
 
 const std::vector<option>  get_option_names() {
   static const std::vector<option> option_names = {
@@ -16,6 +17,36 @@ const std::vector<option>  get_option_names() {
     { "outputDirectory", "Directory where output will be written. Default is \"out\"", STRING_SWITCH_SETTER(outputDirectory) },
     { "printReferenceGraph", "Displays the list of types that reference each type", BOOL_SWITCH_SETTER(printReferenceGraph )},
     { "strictReferences", "Produce an error when failing to resolve a reference", BOOL_SWITCH_SETTER(strictReferences)},
+    { "streaming", "Process one namespace at a time and spill back-references to disk to bound memory use", BOOL_SWITCH_SETTER(streaming)},
+    { "watch", "Keep running and regenerate the pages that changed whenever the WinMD is rewritten", BOOL_SWITCH_SETTER(watch)},
+    { "serve", "Answer requests for single types or members on stdin/stdout instead of writing files", BOOL_SWITCH_SETTER(serve)},
+    { "outputBundle", "Write every page into this single indexed bundle file instead of one file per page", STRING_SWITCH_SETTER(outputBundle)},
+    { "extractBundle", "Expand a bundle written by /outputBundle into /outputDirectory and exit", STRING_SWITCH_SETTER(extractBundle)},
+    { "outputArchive", "Write every page straight into a .zip, .tar.gz or .tar archive instead of the output directory", STRING_SWITCH_SETTER(outputArchive)},
+    { "precompress", "Also write a .gz copy of every output file, skipping files whose existing .gz is up to date", BOOL_SWITCH_SETTER(precompress)},
+    { "emit", "Also write the documentation model as structured records; the only format is ndjson (one JSON record per type and member)", STRING_SWITCH_SETTER(emit)},
+    { "emitFile", "File that /emit writes to. Default is stdout", STRING_SWITCH_SETTER(emitFile)},
+    { "outputSnapshot", "Also save the resolved documentation model, pages and back-references to this binary snapshot file", STRING_SWITCH_SETTER(outputSnapshot)},
+    { "fromSnapshot", "Write the docs from a snapshot saved with /outputSnapshot instead of reading any WinMD", STRING_SWITCH_SETTER(fromSnapshot)},
+    { "searchIndex", "Also write search-index.json, an inverted index of type and member names and doc terms for client-side search", BOOL_SWITCH_SETTER(searchIndex)},
+    { "checkLinks", "Check every link between the generated pages and report the broken ones (exit code 1 if there are any)", BOOL_SWITCH_SETTER(checkLinks)},
+    { "diffFrom", "Instead of the docs, write api-changes.md and api-changes.json listing what changed since this older WinMD or snapshot", STRING_SWITCH_SETTER(diffFrom)},
+    { "contentStore", "Store each page body once in this directory, shared between API versions, and hard-link it into the output directory; front matter goes to front-matter.json", STRING_SWITCH_SETTER(contentStore)},
+    { "fanOut", "Spread the pages over subdirectories: namespace (one per namespace) or hash (256 buckets by type name)", STRING_SWITCH_SETTER(fanOut)},
+    { "atomicWrites", "Write each file in one go through a temporary file, and leave files whose contents didn't change untouched", BOOL_SWITCH_SETTER(atomicWrites)},
+    { "incremental", "Only write the pages affected by what changed since the last /incremental run into the same output directory", BOOL_SWITCH_SETTER(incremental)},
+    { "namespace", "Only write the pages of namespaces matching these ;-separated patterns (* and ? wildcards); can be repeated", LIST_SWITCH_SETTER(namespaceFilter)},
+    { "excludeNamespace", "Don't write the pages of namespaces matching these patterns; can be repeated", LIST_SWITCH_SETTER(excludeNamespaceFilter)},
+    { "type", "Only write the pages of types matching these patterns, by name or as Namespace.Type; can be repeated", LIST_SWITCH_SETTER(typeFilter)},
+    { "excludeType", "Don't write the pages of types matching these patterns; can be repeated", LIST_SWITCH_SETTER(excludeTypeFilter)},
+    { "withDependencies", "Also write the pages of the types that the selected types refer to or implement, and theirs in turn", BOOL_SWITCH_SETTER(withDependencies)},
+    { "inheritedMembers", "Add a section to class and interface pages listing the members inherited from base classes and required interfaces", BOOL_SWITCH_SETTER(inheritedMembers)},
+    { "shard", "Render only one part of the types, as process i of n (e.g. 3/8), and leave the rest of the docs to /mergeShards", STRING_SWITCH_SETTER(shard)},
+    { "mergeShards", "Combine the output of n /shard runs in the output directory into the same docs a single run writes", STRING_SWITCH_SETTER(mergeShards)},
+    { "indexPageSize", "Split namespace indexes with more types than this into pages per kind and initial letter, sorted by name", 1, [](options* o, std::string value) { o->indexPageSize = std::stoul(value); } },
+    { "html", "Write the pages as self-contained HTML sharing one stylesheet, instead of markdown for a site generator", BOOL_SWITCH_SETTER(html)},
+    { "xrefMap", "Link types from other WinMDs to their docs, as listed in these ;-separated xref maps (xrefmap.yml, or uid<tab>url lines); can be repeated", LIST_SWITCH_SETTER(xrefMap)},
+    { "memoryBudget", "Memory budget in MB for back-references in streaming mode (implies /streaming). Default is 256", 1, [](options* o, std::string value) { o->memoryBudgetMB = std::stoul(value); o->streaming = true; } },
   };
   return option_names;
 }
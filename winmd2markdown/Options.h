@@ -26,6 +26,36 @@ struct options
   bool printReferenceGraph{ false };
   std::string apiVersion;
   bool strictReferences{ false };
+  bool streaming{ false };
+  bool watch{ false };
+  bool serve{ false };
+  std::string outputBundle;
+  std::string extractBundle;
+  std::string outputArchive;
+  bool precompress{ false };
+  std::string emit;
+  std::string emitFile;
+  std::string outputSnapshot;
+  std::string fromSnapshot;
+  bool searchIndex{ false };
+  bool checkLinks{ false };
+  std::string diffFrom;
+  std::string contentStore;
+  std::string fanOut;
+  bool atomicWrites{ false };
+  bool incremental{ false };
+  std::string namespaceFilter;
+  std::string excludeNamespaceFilter;
+  std::string typeFilter;
+  std::string excludeTypeFilter;
+  bool withDependencies{ false };
+  bool inheritedMembers{ false };
+  std::string shard;
+  std::string mergeShards;
+  size_t indexPageSize{ 0 };
+  bool html{ false };
+  std::string xrefMap;
+  size_t memoryBudgetMB{ 256 };
 
   options(const std::vector<std::string>& v) {
     auto const opts = get_option_names();
@@ -0,0 +1,19 @@
+#pragma once
+#include <memory>
+#include <ostream>
+#include <string>
+
+/// <summary>
+/// A single file that pages are written into instead of the output directory (/outputBundle, /outputArchive).
+/// Names are relative to the output directory and use '/' separators. Files are buffered until Flush, which the
+/// program calls at the end of each namespace once the "Referenced by" sections have been appended; Close finishes
+/// the file. A writer destroyed without Close was part of a failed run, and deletes the file instead of passing it
+/// off as complete.
+/// </summary>
+struct package_writer
+{
+  virtual ~package_writer() = default;
+  virtual std::shared_ptr<std::ostream> Open(const std::string& name, bool append) = 0;
+  virtual void Flush() = 0;
+  virtual void Close() = 0;
+};
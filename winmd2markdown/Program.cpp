@@ -1,10 +1,17 @@
+#include <cctype>
 #include <string_view>
 #include <sstream>
-#include <boost/algorithm/string/replace.hpp>
+#include <chrono>
+#include <fcntl.h>
+#include <io.h>
 
 #include "Program.h"
 #include "Options.h"
 #include "Format.h"
+#include "Archive.h"
+#include "Bundle.h"
+#include "MappedFile.h"
+#include "Watch.h"
 
 using namespace winmd::reader;
 using namespace std;
@@ -20,7 +27,7 @@ bool hasAttribute(const pair<CustomAttribute, CustomAttribute>& attrs, string at
   return false;
 }
 
-template<typename T> string GetContentAttributeValue(string attrname, const T& t)
+template<typename T> string_view GetContentAttributeValue(string_view attrname, const T& t)
 {
   for (auto const& ca : t.CustomAttribute()) {
     const auto tnn = ca.TypeNamespaceAndName();
@@ -32,10 +39,7 @@ template<typename T> string GetContentAttributeValue(string attrname, const T& t
         if (argname == "Content") {
           auto const argvalue = arg.value;
           auto const& elemSig = std::get<ElemSig>(argvalue.value);
-          const string val{ std::get<string_view>(elemSig.value) };
-
-          auto ret = boost::replace_all_copy(val, "\\n", "\n");
-          return ret;
+          return std::get<string_view>(elemSig.value);
         }
       }
     }
@@ -45,22 +49,15 @@ template<typename T> string GetContentAttributeValue(string attrname, const T& t
 
 
 template<typename T>
-string GetDocString(const T& t) {
-  string val = GetContentAttributeValue("DocStringAttribute", t);
-  auto sane = boost::replace_all_copy(val, "\\n", "\n");
-  boost::replace_all(sane, "\\r", "\r");
-  boost::replace_all(sane, "\r\n", "\n");
-  boost::replace_all(sane, "/-/", "//");
-
-  return sane;
+unescaped_text GetDocString(const T& t) {
+  return UnescapeDocText(GetContentAttributeValue("DocStringAttribute", t), true);
 }
 
 template<typename T>
 string GetDocDefault(const T& t) {
-  string val = GetContentAttributeValue("DocDefaultAttribute", t);
-  if (val.empty()) return val;
-  auto ret = code(val);
-  return ret;
+  const auto val = UnescapeDocText(GetContentAttributeValue("DocDefaultAttribute", t), false);
+  if (val.empty()) return {};
+  return code(val);
 }
 
 
@@ -88,13 +85,30 @@ string Program::GetDeprecated(const T& type, Converter converter)
       const std::vector<winmd::reader::FixedArgSig>& args = depr.FixedArgs();
       auto const argvalue = args[0].value;
       auto const& elemSig = std::get<ElemSig>(argvalue);
-      const string val{ std::get<string_view>(elemSig.value) };
-      return format.ResolveReferences(val, converter);
+      return format.ResolveReferences(std::get<string_view>(elemSig.value), converter);
     }
   }
   return {};
 }
 
+template<typename T, typename F>
+model_record Program::MakeRecord(model_kind kind, const TypeDef& type, string_view member, const T& item, std::optional<F> fallback_type)
+{
+  model_record record;
+  record.kind = kind;
+  record.ns = type.TypeNamespace();
+  record.type = type.TypeName();
+  record.member = member;
+  record.experimental = IsExperimental(item);
+  record.deprecated = GetDeprecated(item, &Formatter::MakeQualifiedReference);
+  if constexpr (!std::is_same<F, nullptr_t>()) {
+    if (record.deprecated.empty()) record.deprecated = GetDeprecated(fallback_type.value(), &Formatter::MakeQualifiedReference);
+  }
+  record.defaultValue = UnescapeDocText(GetContentAttributeValue("DocDefaultAttribute", item), false);
+  record.doc = format.ResolveReferences(GetDocString(item), &Formatter::MakeQualifiedReference);
+  return record;
+}
+
 template<typename IT>
 bool Program::shouldSkipInterface(const IT /*TypeDef*/& interfaceEntry) {
 #ifdef DEBUG
@@ -110,12 +124,13 @@ bool Program::shouldSkipInterface(const IT /*TypeDef*/& interfaceEntry) {
 /// Prints information that may be missing, e.g. description, whether the type is experimental or not, whether it's deprecated
 /// For properties, custom attributes can live in the getter/setter method instead of the property itself.
 /// </summary>
+/// <typeparam name="mt">The kind of member, used for the intellisense XML entry</typeparam>
 /// <typeparam name="T"></typeparam>
 /// <param name="ss"></param>
 /// <param name="type"></param>
 /// <param name="fallback_type"></param>
-template<typename T, typename F = nullptr_t>
-void Program::PrintOptionalSections(MemberType mt, output& ss, const T& type, std::optional<F> fallback_type)
+template<MemberType mt, typename T, typename F = nullptr_t>
+void Program::PrintOptionalSections(output& ss, const T& type, std::optional<F> fallback_type)
 {
   if (IsExperimental(type)) {
     ss << "> **EXPERIMENTAL**\n\n";
@@ -146,7 +161,11 @@ void Program::PrintOptionalSections(MemberType mt, output& ss, const T& type, st
     else {
       name = string(type.Parent().TypeName()) + "." + string(type.Name());
     }
-    ss.currentXml.AddMember(mt, name, format.ResolveReferences(doc, &Formatter::MakeXmlReference));
+    auto xml = format.ResolveReferences(doc, &Formatter::MakeXmlReference);
+    if (ss.snapshot) {
+      ss.snapshot->AddXmlMember(intellisense_xml::ToString(mt), name, xml);
+    }
+    ss.currentXml.AddMember(mt, name, std::move(xml));
   }
 }
 
@@ -181,53 +200,167 @@ DEFINE_ENUM_FLAG_OPERATORS(MemberAccess);
 
 
 
-void Program::process(std::string_view namespaceName, const cache::namespace_members& ns) {
-  ss.StartNamespace(namespaceName);
-  for (auto const& enumEntry : ns.enums) {
-    if (!opts->outputExperimental && IsExperimental(enumEntry)) continue;
-    process_enum(ss, enumEntry);
+namespace {
+  // Program::runtimeLayouts
+  struct runtime_property_layout { static bool AsTable(const options& o) { return o.propertiesAsTable; } };
+  struct runtime_field_layout { static bool AsTable(const options& o) { return o.fieldsAsTable; } };
+}
+
+Program::namespace_processor Program::SelectLayout() const {
+  if (shard) {
+    if (opts->propertiesAsTable) {
+      return opts->fieldsAsTable ? &Program::process_shard<table_layout, table_layout> : &Program::process_shard<table_layout, section_layout>;
+    }
+    return opts->fieldsAsTable ? &Program::process_shard<section_layout, table_layout> : &Program::process_shard<section_layout, section_layout>;
+  }
+  if (runtimeLayouts) {
+    return &Program::process<runtime_property_layout, runtime_field_layout>;
   }
+  if (opts->propertiesAsTable) {
+    return opts->fieldsAsTable ? &Program::process<table_layout, table_layout> : &Program::process<table_layout, section_layout>;
+  }
+  else {
+    return opts->fieldsAsTable ? &Program::process<section_layout, table_layout> : &Program::process<section_layout, section_layout>;
+  }
+}
 
-  for (auto const& classEntry : ns.classes) {
-    if (!opts->outputExperimental && IsExperimental(classEntry)) continue;
-    process_class(ss, classEntry, "class");
+Program::namespace_types Program::select_types(const cache::namespace_members& ns) {
+  namespace_types types;
+  auto select = [this](const auto& entries, std::vector<TypeDef>& selected) {
+    for (auto const& t : entries) {
+      if (!opts->outputExperimental && IsExperimental(t)) continue;
+      selected.push_back(t);
+    }
+  };
+  select(ns.enums, types.enums);
+  select(ns.classes, types.classes);
+  for (auto const& t : ns.interfaces) {
+    if (shouldSkipInterface(t)) continue;
+    types.interfaces.push_back(t);
   }
+  select(ns.structs, types.structs);
+  select(ns.delegates, types.delegates);
+  return types;
+}
 
-  for (auto const& interfaceEntry : ns.interfaces) {
-    if (!shouldSkipInterface(interfaceEntry)) {
-      process_class(ss, interfaceEntry, "interface");
+Program::index_entries Program::namespace_types::Index() const {
+  index_entries index;
+  const std::pair<model_kind, const std::vector<TypeDef>*> kinds[] = {
+    { model_kind::Enum, &enums }, { model_kind::Interface, &interfaces }, { model_kind::Struct, &structs },
+    { model_kind::Class, &classes }, { model_kind::Delegate, &delegates },
+  };
+  for (const auto& [kind, entries] : kinds) {
+    for (auto const& t : *entries) {
+      index[kind].push_back(t.TypeName());
     }
   }
+  return index;
+}
 
-  for (auto const& structEntry : ns.structs) {
-    if (!opts->outputExperimental && IsExperimental(structEntry)) continue;
-    process_struct(ss, structEntry);
+template<typename PropertyLayout, typename FieldLayout>
+void Program::process(std::string_view namespaceName, const cache::namespace_members& ns) {
+  ss.StartNamespace(namespaceName);
+  const auto types = select_types(ns);
+  for (auto const& enumEntry : types.enums) {
+    process_enum(ss, enumEntry);
+  }
+  for (auto const& classEntry : types.classes) {
+    process_class<PropertyLayout>(ss, classEntry, "class");
+  }
+  for (auto const& interfaceEntry : types.interfaces) {
+    process_class<PropertyLayout>(ss, interfaceEntry, "interface");
   }
+  for (auto const& structEntry : types.structs) {
+    process_struct<FieldLayout>(ss, structEntry);
+  }
+  for (auto const& delegateEntry : types.delegates) {
+    process_delegate(ss, delegateEntry);
+  }
+  write_index(namespaceName, types.Index());
 
+  if (spill) {
+    // Back-references are merged once all namespaces are done; release what this namespace was holding on to
+    for (auto const& interfaceEntry : ns.interfaces) {
+      interfaceImplementations.erase(string(interfaceEntry.TypeName()));
+    }
+  }
+  else {
+    if (opts->printReferenceGraph) std::cout << "Reference graph:\n";
+    for (const auto& backReference : references[string(namespaceName)]) {
+      std::vector<std::string> sorted;
+      for (auto const& x : backReference.second) {
+        // after a full pass, only the referrers a full run would have rendered by the end of this namespace
+        if (renderOrder.empty() || x.TypeNamespace() <= namespaceName) sorted.push_back(string(x.TypeName()));
+      }
+      if (sorted.empty()) continue;
+      std::sort(sorted.begin(), sorted.end());
+      write_referenced_by(namespaceName, backReference.first, sorted);
+    }
+  }
+  ss.EndNamespace();
+}
 
-  for (auto const& delegateEntry : ns.delegates) {
-    if (!opts->outputExperimental && IsExperimental(delegateEntry)) continue;
-    process_delegate(ss, delegateEntry);
+template<typename PropertyLayout, typename FieldLayout>
+void Program::process_shard(std::string_view namespaceName, const cache::namespace_members& ns) {
+  // Same order and filters as process, so every shard numbers the types the same way
+  shard->StartNamespace(namespaceName);
+  auto visit = [&](const TypeDef& type, model_kind kind, auto render) {
+    const auto seq = shard->NextType();
+    if (!shard->Owns(namespaceName, type.TypeName())) return;
+    const auto xml = std::make_shared<std::ostringstream>();
+    ss.currentXml = intellisense_xml(namespaceName, xml, true);
+    render();
+    ss.currentXml = intellisense_xml();
+    shard->AddType(seq, kind, namespaceName, type.TypeName(), xml->str());
+  };
+  const auto types = select_types(ns);
+  for (auto const& enumEntry : types.enums) {
+    visit(enumEntry, model_kind::Enum, [&]() { process_enum(ss, enumEntry); });
   }
+  for (auto const& classEntry : types.classes) {
+    visit(classEntry, model_kind::Class, [&]() { process_class<PropertyLayout>(ss, classEntry, "class"); });
+  }
+  for (auto const& interfaceEntry : types.interfaces) {
+    visit(interfaceEntry, model_kind::Interface, [&]() { process_class<PropertyLayout>(ss, interfaceEntry, "interface"); });
+  }
+  for (auto const& structEntry : types.structs) {
+    visit(structEntry, model_kind::Struct, [&]() { process_struct<FieldLayout>(ss, structEntry); });
+  }
+  for (auto const& delegateEntry : types.delegates) {
+    visit(delegateEntry, model_kind::Delegate, [&]() { process_delegate(ss, delegateEntry); });
+  }
+  ss.EndNamespace();
+}
 
-  write_index(namespaceName, ns);
+void Program::write_referenced_by(string_view namespaceName, string_view typeName, const std::vector<std::string>& sortedReferrers) {
+  if (ss.pageFilter && !ss.pageFilter(namespaceName, typeName)) return;
+  const auto md = ss.OpenFile(ss.GetFileForType(typeName, namespaceName), true);
+  if (ss.links) {
+    for (const auto& referrer : sortedReferrers) {
+      ss.links->AddLink(typeName, "Referenced by", referrer);
+    }
+  }
+  if (ss.snapshot) {
+    ss.snapshot->AddReferrers(namespaceName, typeName, sortedReferrers);
+  }
+  if (opts->printReferenceGraph) std::cout << typeName << " <-- ";
+  print_referenced_by(*md, namespaceName, typeName, sortedReferrers);
+  if (opts->printReferenceGraph) {
+    for (const auto& i : sortedReferrers) {
+      std::cout << i << "  ";
+    }
+    std::cout << "\n";
+  }
+}
 
-  if (opts->printReferenceGraph) std::cout << "Reference graph:\n";
-  for (const auto& backReference : references[string(namespaceName)]) {
-    std::ofstream md(ss.GetFileForType(backReference.first), std::ofstream::out | std::ofstream::app);
-    if (opts->printReferenceGraph) std::cout << backReference.first << " <-- ";
-    md << R"(
+void Program::print_referenced_by(std::ostream& md, std::string_view namespaceName, std::string_view typeName, const std::vector<std::string>& sortedReferrers) {
+  md << R"(
 
 ## Referenced by
 )";
-    std::vector<std::string> sorted;
-    std::for_each(backReference.second.begin(), backReference.second.end(), [&sorted](auto& x) { sorted.push_back(string(x.TypeName())); });
-    std::sort(sorted.begin(), sorted.end());
-    for (const auto& i : sorted) {
-      md << link(i) << "\n";
-      if (opts->printReferenceGraph) std::cout << i << "  ";
-    }
-    if (opts->printReferenceGraph) std::cout << "\n";
+  const auto directory = ss.GetPageDirectory(typeName, namespaceName);
+  for (const auto& i : sortedReferrers) {
+    md << link(i, ss.GetLinkToType(i, directory, namespaceName)) << "\n";
   }
 }
 
@@ -240,6 +373,7 @@ MethodDef FindMethodInType(const TypeDef& type, const std::string& name) {
   return {};
 }
 
+template<typename PropertyLayout>
 void Program::process_class(output& ss, const TypeDef& type, string kind) {
   const auto& className = string(type.TypeName());
   const auto t = ss.StartType(className, kind);
@@ -249,16 +383,28 @@ void Program::process_class(output& ss, const TypeDef& type, string kind) {
     ss << "Extends: " + extends << "\n\n";
   }
 
-  if (kind == "interface" && interfaceImplementations.find(className) != interfaceImplementations.end())
+  if (shard && kind == "interface") {
+    // only the merge knows every implementer
+    ss << shard_writer::implementedByMarker;
+  }
+  else if (kind == "interface" && interfaceImplementations.find(className) != interfaceImplementations.end())
   {
-    ss << "Implemented by: \n";
+    std::vector<const TypeDef*> implementers;
     for (auto const& imp : interfaceImplementations[className])
     {
-      ss << "- " << format.typeToMarkdown(imp.TypeNamespace(), string(imp.TypeName()), true) << "\n";
+      if (RenderedBefore(imp, type)) implementers.push_back(&imp);
+    }
+    if (!implementers.empty()) {
+      ss << "Implemented by: \n";
+      for (const auto* imp : implementers)
+      {
+        ss << "- " << format.typeToMarkdown(imp->TypeNamespace(), string(imp->TypeName()), true) << "\n";
+      }
     }
   }
 
   // Print interface implementations
+  std::vector<std::string> implements;
   {
     int i = 0;
     for (auto const& ii : type.InterfaceImpl()) {
@@ -267,10 +413,12 @@ void Program::process_class(output& ss, const TypeDef& type, string kind) {
       const auto tdr = iface.type();
       TypeDef td{};
       std::string ifaceName;
+      std::string_view ifaceNamespace;
       if (tdr == TypeDefOrRef::TypeRef) {
 
         const auto& tr = iface.TypeRef();
         ifaceName = string(tr.TypeName());
+        ifaceNamespace = tr.TypeNamespace();
 
         td = cache->find(tr.TypeNamespace(), tr.TypeName());
         if (shouldSkipInterface(td)) continue;
@@ -278,6 +426,7 @@ void Program::process_class(output& ss, const TypeDef& type, string kind) {
       else if (tdr == TypeDefOrRef::TypeDef) {
         td = iface.TypeDef();
         ifaceName = string(td.TypeName());
+        ifaceNamespace = td.TypeNamespace();
         if (shouldSkipInterface(td)) continue;
       }
       else if (tdr == TypeDefOrRef::TypeSpec) {
@@ -296,11 +445,26 @@ void Program::process_class(output& ss, const TypeDef& type, string kind) {
       }
       i++;
       ss << format.ToString(ii.Interface());
-      interfaceImplementations[ifaceName].push_back(TypeDef(type));
+      if (ss.Modeling()) {
+        implements.push_back(format.GetQualifiedType(ii.Interface()));
+      }
+      // when streaming, only keep implementations for interfaces whose page hasn't been written yet
+      if (!spill || (ifaceNamespace >= currentNamespace && !ifaceNamespace._Starts_with("Windows."))) {
+        auto& implementations = interfaceImplementations[ifaceName];
+        if (std::find(implementations.cbegin(), implementations.cend(), type) == implementations.cend()) {
+          implementations.push_back(TypeDef(type));
+        }
+      }
     }
     ss << "\n\n";
   }
-  PrintOptionalSections(MemberType::Type, ss, type);
+  PrintOptionalSections<MemberType::Type>(ss, type);
+  if (ss.Modeling()) {
+    auto record = MakeRecord(kind == "interface" ? model_kind::Interface : model_kind::Class, type, {}, type);
+    record.valueType = format.GetQualifiedType(type.Extends());
+    record.implements = std::move(implements);
+    ss.Record(record);
+  }
 
   // Print properties
   {
@@ -313,12 +477,12 @@ void Program::process_class(output& ss, const TypeDef& type, string kind) {
     sorted.sort([](const entry_t& x, const entry_t& y) { return x.first < y.first; });
     if (!sorted.empty()) {
       auto ps = ss.StartSection("Properties");
-      if (opts->propertiesAsTable) {
+      if (PropertyLayout::AsTable(*opts)) {
         ss << "|   | Name|Type|Description|" << "\n"
           << "|---|-----|----|-----------|" << "\n";
       }
       for (auto const& prop : sorted) {
-        process_property(ss, prop.second);
+        process_property<PropertyLayout>(ss, prop.second);
       }
     }
   }
@@ -379,16 +543,85 @@ void Program::process_class(output& ss, const TypeDef& type, string kind) {
     if (!sorted.empty()) {
       auto es = ss.StartSection("Events");
       for (auto const& evt : sorted) {
-        auto n = string(evt.first);
-        auto ees = ss.StartSection("`" + string(evt.first) + "`");
-        auto methodList = type.MethodList();
-        auto addMethod = FindMethodInType(type, "add_" + n);
-        PrintOptionalSections(MemberType::Event, ss, addMethod);
-        ss << "Type: " << format.ToString(evt.second.EventType()) << "\n";
-        AddReference(evt.second.EventType(), type);
+        process_event(ss, type, evt.second);
       }
     }
   }
+
+  if (opts->inheritedMembers) {
+    print_inherited_members(ss, type);
+  }
+}
+
+std::optional<inheritance_graph::type_info> Program::InheritanceOf(std::string_view name) {
+  const auto dot = name.rfind('.');
+  if (dot == string_view::npos) return std::nullopt;
+  const auto type = cache->find(name.substr(0, dot), name.substr(dot + 1));
+  if (!type) return std::nullopt;
+
+  inheritance_graph::type_info info;
+  for (auto const& prop : type.PropertyList()) {
+    if (!opts->outputExperimental && IsExperimental(prop)) continue;
+    info.declared.push_back({ model_kind::Property, string(prop.Name()) });
+  }
+  for (auto const& method : type.MethodList()) {
+    // constructors aren't inherited, and accessors are listed as their property or event
+    if (method.SpecialName() || (!opts->outputExperimental && IsExperimental(method))) continue;
+    info.declared.push_back({ model_kind::Method, string(method.Name()) });
+  }
+  for (auto const& evt : type.EventList()) {
+    if (!opts->outputExperimental && IsExperimental(evt)) continue;
+    info.declared.push_back({ model_kind::Event, string(evt.Name()) });
+  }
+
+  const auto extends = format.GetQualifiedType(type.Extends());
+  if (!extends.empty() && extends != "System.Object") {
+    info.bases.push_back(extends);
+  }
+  for (auto const& ii : type.InterfaceImpl()) {
+    if (ii.Interface().type() == TypeDefOrRef::TypeSpec) continue; // generic instances, e.g. IVector<T>
+    const auto iface = format.GetQualifiedType(ii.Interface());
+    const auto idot = iface.rfind('.');
+    const auto td = idot == string::npos ? TypeDef{} : cache->find(string_view(iface).substr(0, idot), string_view(iface).substr(idot + 1));
+    // a class's exclusive interfaces are already in its own member list
+    if (td && shouldSkipInterface(td)) continue;
+    info.bases.push_back(iface);
+  }
+  return info;
+}
+
+void Program::print_inherited_members(output& ss, const TypeDef& type) {
+  if (!inheritance) {
+    inheritance = std::make_unique<inheritance_graph>([this](std::string_view name) { return InheritanceOf(name); });
+  }
+  const auto groups = inheritance->Inherited(string(type.TypeNamespace()) + "." + string(type.TypeName()));
+  if (groups->empty()) return;
+
+  ss << "\n";
+  auto is = ss.StartSection("Inherited members");
+  for (const auto& g : *groups) {
+    const auto dot = g.type.rfind('.');
+    ss << "From " << format.typeToMarkdown(g.type.substr(0, dot), string(g.type.substr(dot + 1)), true) << ":\n";
+    for (const auto* m : *g.members) {
+      ss << "- `" << m->name << "` (" << string(ToString(m->kind)) << ")\n";
+    }
+    ss << "\n";
+  }
+}
+
+void Program::process_event(output& ss, const TypeDef& type, const Event& evt) {
+  const auto n = string(evt.Name());
+  auto ees = ss.StartSection("`" + n + "`");
+  auto addMethod = FindMethodInType(type, "add_" + n);
+  PrintOptionalSections<MemberType::Event>(ss, addMethod);
+  ss << "Type: " << format.ToString(evt.EventType()) << "\n";
+  AddReference(evt.EventType(), type);
+  if (ss.Modeling()) {
+    auto record = MakeRecord(model_kind::Event, type, n, addMethod);
+    record.valueType = format.GetQualifiedType(evt.EventType());
+    record.signature = "event " + record.valueType + " " + n;
+    ss.Record(record);
+  }
 }
 
 
@@ -396,6 +629,14 @@ template <typename T>
 void Program::AddUniqueReference(const T& type, const TypeDef& owningType)
 {
   if (type.TypeNamespace() == owningType.TypeNamespace() && type.TypeName() == owningType.TypeName()) return;
+  if (spill) {
+    // Without /streaming a type's list is written when its namespace is done, so it never shows referrers from the
+    // namespaces after it; keep the pages the same
+    if (!type.TypeNamespace()._Starts_with("Windows.") && owningType.TypeNamespace() <= type.TypeNamespace()) {
+      spill->Add(type.TypeNamespace(), type.TypeName(), owningType.TypeNamespace(), owningType.TypeName());
+    }
+    return;
+  }
   auto& vec = references[string(type.TypeNamespace())][string(type.TypeName())];
   if (std::find(vec.cbegin(), vec.cend(), owningType) == vec.cend()) {
     vec.push_back(owningType);
@@ -441,6 +682,7 @@ void Program::AddReference(const TypeSig& prop, const TypeDef& owningType) {
   }
 }
 
+template<typename PropertyLayout>
 void Program::process_property(output& ss, const Property& prop) {
   const auto& type = format.GetType(prop.Type().Type());
   const auto& name = code(prop.Name());
@@ -463,9 +705,8 @@ void Program::process_property(output& ss, const Property& prop) {
 
   auto default_val = GetDocDefault(prop);
   auto cppAttrs = (isStatic ? (code("static") + "   ") : "") + (readonly ? (code("readonly") + " ") : "");
-  if (opts->propertiesAsTable) {
-    auto description = GetDocString(prop);
-    description = format.ResolveReferences(description, &Formatter::MakeMarkdownReference);
+  if (PropertyLayout::AsTable(*opts)) {
+    auto description = format.ResolveReferences(GetDocString(prop), &Formatter::MakeMarkdownReference);
     if (!default_val.empty()) {
       description += "<br/>default: " + default_val;
     }
@@ -474,9 +715,17 @@ void Program::process_property(output& ss, const Property& prop) {
   else {
     auto sec = ss.StartSection(propName);
     ss << cppAttrs << " " << type << " " << name << "\n\n";
-    PrintOptionalSections(MemberType::Property, ss, prop, std::make_optional(getter));
+    PrintOptionalSections<MemberType::Property>(ss, prop, std::make_optional(getter));
 
   }
+  if (ss.Modeling()) {
+    auto record = MakeRecord(model_kind::Property, owningType, propName, prop, std::make_optional(getter));
+    record.valueType = format.GetQualifiedType(prop.Type().Type());
+    record.isStatic = isStatic;
+    record.readonly = readonly;
+    record.signature = (isStatic ? "static " : "") + string(readonly ? "readonly " : "") + record.valueType + " " + propName;
+    ss.Record(record);
+  }
 }
 
 void Program::process_method(output& ss, const MethodDef& method, string_view realName) {
@@ -512,6 +761,7 @@ void Program::process_method(output& ss, const MethodDef& method, string_view re
     paramNames.erase(paramNames.begin());
   }
 
+  std::vector<model_parameter> params;
   for (const auto& param : signature.Params()) {
     if (i != 0) {
       sstr << ", ";
@@ -520,6 +770,9 @@ void Program::process_method(output& ss, const MethodDef& method, string_view re
     const auto out = param.ByRef() ? "**out** " : "";
     sstr << out << format.GetType(param.Type()) << " " << paramNames[i];
     AddReference(param.Type(), method.Parent());
+    if (ss.Modeling()) {
+      params.push_back({ string(paramNames[i]), format.GetQualifiedType(param.Type()), param.ByRef() });
+    }
     i++;
   }
   sstr << ")";
@@ -527,15 +780,31 @@ void Program::process_method(output& ss, const MethodDef& method, string_view re
   auto st = ss.StartSection(method_name);
   ss << sstr.str() << "\n\n";
 
-  PrintOptionalSections(MemberType::Method, ss, method);
+  PrintOptionalSections<MemberType::Method>(ss, method);
   ss << "\n\n";
+  if (ss.Modeling()) {
+    auto record = MakeRecord(realName.empty() ? model_kind::Method : model_kind::Constructor, method.Parent(), name, method);
+    if (realName.empty()) {
+      const auto& sig = method.Signature();
+      record.valueType = sig.ReturnType() ? format.GetQualifiedType(sig.ReturnType().Type()) : "void";
+    }
+    record.isStatic = flags.Static();
+    record.signature = (flags.Static() ? "static " : "") + (record.valueType.empty() ? "" : record.valueType + " ") + string(name) + "(";
+    for (size_t p = 0; p < params.size(); p++) {
+      record.signature += (p != 0 ? ", " : "") + string(params[p].out ? "out " : "") + params[p].type + " " + params[p].name;
+    }
+    record.signature += ")";
+    record.parameters = std::move(params);
+    ss.Record(record);
+  }
 }
 
 
+template<typename FieldLayout>
 void Program::process_field(output& ss, const Field& field) {
   const auto& type = format.GetType(field.Signature().Type());
   const auto& name = string(field.Name());
-  if (opts->fieldsAsTable) {
+  if (FieldLayout::AsTable(*opts)) {
     auto description = format.ResolveReferences(GetDocString(field), &Formatter::MakeMarkdownReference);
     ss << "| " << name << " | " << type << " | " << description << " |\n";
   }
@@ -554,14 +823,23 @@ void Program::process_field(output& ss, const Field& field) {
       typeStr = format.GetType(tt);
     }
     ss << "Type: " << typeStr << "\n\n";
-    PrintOptionalSections(MemberType::Field, ss, field);
+    PrintOptionalSections<MemberType::Field>(ss, field);
+  }
+  if (ss.Modeling()) {
+    auto record = MakeRecord(model_kind::Field, field.Parent(), name, field);
+    record.valueType = format.GetQualifiedType(field.Signature().Type());
+    record.signature = record.valueType + " " + name;
+    ss.Record(record);
   }
-
 }
 
+template<typename FieldLayout>
 void Program::process_struct(output& ss, const TypeDef& type) {
   const auto t = ss.StartType(type.TypeName(), "struct");
-  PrintOptionalSections(MemberType::Type, ss, type);
+  PrintOptionalSections<MemberType::Type>(ss, type);
+  if (ss.Modeling()) {
+    ss.Record(MakeRecord(model_kind::Struct, type, {}, type));
+  }
 
   const auto fs = ss.StartSection("Fields");
 
@@ -571,18 +849,21 @@ void Program::process_struct(output& ss, const TypeDef& type) {
     sorted.push_back(make_pair<string_view, const Field>(field.Name(), Field(field)));
   }
   sorted.sort([](const entry_t& x, const entry_t& y) { return x.first < y.first; });
-  if (opts->fieldsAsTable) {
+  if (FieldLayout::AsTable(*opts)) {
     ss << "| Name | Type | Description |" << "\n" << "|---|---|---|" << "\n";
   }
   for (auto const& field : sorted) {
     if (!opts->outputExperimental && IsExperimental(field.second)) continue;
-    process_field(ss, field.second);
+    process_field<FieldLayout>(ss, field.second);
   }
 }
 
 void Program::process_delegate(output& ss, const TypeDef& type) {
   const auto t = ss.StartType(type.TypeName(), "delegate");
-  PrintOptionalSections(MemberType::Type, ss, type);
+  PrintOptionalSections<MemberType::Type>(ss, type);
+  if (ss.Modeling()) {
+    ss.Record(MakeRecord(model_kind::Delegate, type, {}, type));
+  }
   for (auto const& method : type.MethodList()) {
     constexpr auto invokeName = "Invoke";
     const auto& name = method.Name();
@@ -632,7 +913,10 @@ T getVariantValueAs(const Constant::constant_type& ct) {
 
 void Program::process_enum(output& ss, const TypeDef& type) {
   auto t = ss.StartType(type.TypeName(), "enum");
-  PrintOptionalSections(MemberType::Type, ss, type);
+  PrintOptionalSections<MemberType::Type>(ss, type);
+  if (ss.Modeling()) {
+    ss.Record(MakeRecord(model_kind::Enum, type, {}, type));
+  }
 
   ss << "| Name |  Value | Description |\n" << "|--|--|--|\n";
   for (auto const& value : type.FieldList()) {
@@ -643,6 +927,14 @@ void Program::process_enum(output& ss, const TypeDef& type) {
     const auto val = getVariantValueAs<int64_t>(value.Constant().Value());
 
     ss << "|" << code(value.Name()) << " | " << std::hex << "0x" << val << "  |  " << format.ResolveReferences(GetDocString(value), &Formatter::MakeMarkdownReference) << "|\n";
+    if (ss.Modeling()) {
+      auto record = MakeRecord(model_kind::EnumValue, type, value.Name(), value);
+      record.value = val;
+      std::ostringstream signature;
+      signature << value.Name() << " = 0x" << std::hex << val;
+      record.signature = signature.str();
+      ss.Record(record);
+    }
   }
 }
 
@@ -667,74 +959,935 @@ int Program::Process(std::vector<std::string> argv) {
     return 0;
   }
 
-  std::vector<string> files = {
-    getWindowsWinMd(),
-    opts->winMDPath,
-  };
+  if (!opts->extractBundle.empty()) {
+    const auto extracted = bundle_reader(filesystem::u8path(opts->extractBundle)).ExtractTo(opts->outputDirectory);
+    cout << "Extracted " << extracted << " files to " << opts->outputDirectory << "\n";
+    return 0;
+  }
+
+  for (string_view maps = opts->xrefMap; !maps.empty(); ) {
+    const auto end = maps.find(';');
+    if (end != 0) {
+      xrefs.Load(filesystem::u8path(maps.substr(0, end)));
+    }
+    if (end == string_view::npos) break;
+    maps.remove_prefix(end + 1);
+  }
+  if (!opts->diffFrom.empty()) {
+    return Diff();
+  }
+  if (!opts->mergeShards.empty()) {
+    return MergeShards();
+  }
+  if (!opts->fromSnapshot.empty()) {
+    return RenderSnapshot();
+  }
+
+  const auto windowsWinMd = getWindowsWinMd();
+  if (opts->serve) {
+    return Serve({ windowsWinMd, opts->winMDPath });
+  }
+  if (opts->watch) {
+    return Watch(windowsWinMd);
+  }
+  Generate({ windowsWinMd, opts->winMDPath });
+  return brokenLinks == 0 ? 0 : 1;
+}
+
+void Program::Generate(const std::vector<std::string>& files) {
   cache = std::make_unique<winmd::reader::cache>(files);
+  inheritance.reset();
+  renderOrder.clear();
+
+  if (opts->streaming) {
+    filesystem::create_directories(opts->outputDirectory);
+    spill = std::make_unique<reference_spill>(filesystem::path(opts->outputDirectory) / "references.edges", opts->memoryBudgetMB * 1024 * 1024);
+  }
+  OpenOutputs();
+  if (!opts->shard.empty()) {
+    RequirePlainOutput("/shard");
+    shard = std::make_unique<shard_writer>(opts->shard, opts->outputDirectory, OutputFingerprint());
+  }
 
+  // the filters below capture this call's locals; they mustn't outlive it when it throws, since /watch carries on
+  struct filter_reset {
+    output& o;
+    ~filter_reset() { o.pageFilter = nullptr; }
+  } const resetFilter{ ss };
+
+  const auto stateFile = filesystem::path(opts->outputDirectory) / "winmd2md.state";
+  incremental_state state;
+  std::optional<incremental_plan> plan;
+  chrono::milliseconds comparing{};
+  if (opts->incremental) {
+    const auto start = chrono::steady_clock::now();
+    state = CollectState();
+    plan = incremental_plan::Make(incremental_state::Load(stateFile), state);
+    for (const auto& name : plan->removed) {
+      const auto dot = name.rfind('.');
+      std::error_code ec;
+      filesystem::remove(ss.GetFileForType(string_view(name).substr(dot + 1), string_view(name).substr(0, dot)), ec);
+    }
+    ss.pageFilter = [&plan](string_view ns, string_view name) {
+      if (name == "index") return plan->indexes.find(string(ns)) != plan->indexes.end();
+      return plan->pages.find(string(ns) + "." + string(name)) != plan->pages.end();
+    };
+    comparing = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+  }
+  const type_filter filter(opts->namespaceFilter, opts->excludeNamespaceFilter, opts->typeFilter, opts->excludeTypeFilter);
+  std::set<std::string> selection;
+  std::set<std::string, std::less<>> selectedNamespaces;
+  if (filter.Active() || opts->withDependencies) {
+    if (plan) {
+      throw std::invalid_argument("/incremental can't be combined with /namespace, /type or /withDependencies");
+    }
+    selection = SelectTypes(filter);
+    for (const auto& name : selection) {
+      selectedNamespaces.insert(name.substr(0, name.rfind('.')));
+    }
+    cout << "Writing the pages of " << selection.size() << " types in " << selectedNamespaces.size() << " namespaces\n";
+    ss.pageFilter = [&](string_view ns, string_view name) {
+      if (name == "index") return selectedNamespaces.find(ns) != selectedNamespaces.end();
+      return selection.find(string(ns) + "." + string(name)) != selection.end();
+    };
+  }
+
+  const auto process = SelectLayout();
   for (auto const& namespaceEntry : cache->namespaces()) {
     if (namespaceEntry.first._Starts_with("Windows.")) continue;
+    if (plan && !plan->Touches(namespaceEntry.first)) continue;
+    if (ss.pageFilter && !plan && selectedNamespaces.find(namespaceEntry.first) == selectedNamespaces.end()) continue;
     filesystem::path nsPath(namespaceEntry.first);
     filesystem::create_directory(nsPath);
     filesystem::current_path(nsPath);
     currentNamespace = namespaceEntry.first;
     filesystem::current_path("..");
-    process(namespaceEntry.first, namespaceEntry.second);
+    (this->*process)(namespaceEntry.first, namespaceEntry.second);
+  }
+
+  if (spill) {
+    if (opts->printReferenceGraph) std::cout << "Reference graph:\n";
+    const auto& namespaces = cache->namespaces();
+    spill->Merge([&](const string& ns, const string& typeName, const std::vector<std::string>& referrers) {
+      if (string_view(ns)._Starts_with("Windows.") || namespaces.find(ns) == namespaces.end()) return;
+      write_referenced_by(ns, typeName, referrers);
+    });
+    spill.reset();
+  }
+  if (shard) {
+    // what the merge needs from this shard's types: whom they refer to and which interfaces they implement
+    for (const auto& [ns, types] : references) {
+      for (const auto& [typeName, referrers] : types) {
+        for (const auto& r : referrers) {
+          shard->AddReference(ns, typeName, r.TypeNamespace(), r.TypeName());
+        }
+      }
+    }
+    for (const auto& [iface, implementations] : interfaceImplementations) {
+      for (const auto& i : implementations) {
+        shard->AddImplementation(iface, i.TypeNamespace(), i.TypeName());
+      }
+    }
+    shard->Close();
+    cout << "Shard " << shard->Index() << " of " << shard->Count() << ": rendered " << shard->Rendered() << " types\n";
+    shard.reset();
+  }
+  CloseOutputs();
+  if (plan) {
+    state.Save(stateFile);
+    cout << "Wrote " << plan->pages.size() << " pages, skipped " << plan->skipped << " unchanged, removed " << plan->removed.size() <<
+      " (finding them took " << comparing.count() << " ms)\n";
+  }
+}
+
+std::string Program::OutputFingerprint() const {
+  return opts->apiVersion + "|" + opts->fileSuffix + "|" + opts->fanOut + "|" +
+    (opts->propertiesAsTable ? "p" : "") + (opts->fieldsAsTable ? "f" : "") + (opts->outputExperimental ? "x" : "") +
+    (opts->inheritedMembers ? "i" : "") + (xrefs.Empty() ? "" : "|x" + std::to_string(xrefs.ContentHash())) + (opts->indexPageSize != 0 ? "n" + std::to_string(opts->indexPageSize) : "");
+}
+
+void Program::RequirePlainOutput(std::string_view option) const {
+  if (opts->streaming || opts->incremental || type_filter(opts->namespaceFilter, opts->excludeNamespaceFilter, opts->typeFilter, opts->excludeTypeFilter).Active() ||
+    opts->withDependencies || ss.package || ss.siblings || ss.store || ss.html || ss.Modeling() || ss.links) {
+    throw std::invalid_argument(string(option) + " only supports writing pages to the output directory; it can't be combined with /streaming, "
+      "/incremental, /namespace, /type, /outputBundle, /outputArchive, /precompress, /contentStore, /html, /emit, /outputSnapshot, /searchIndex or /checkLinks");
+  }
+}
+
+std::set<std::string> Program::SelectTypes(const type_filter& filter) {
+  if (spill) {
+    throw std::invalid_argument("/namespace, /type and /withDependencies can't be combined with /streaming");
+  }
+  // The selected pages' back-references can come from any type, so every type goes through once into a discarded
+  // stream, and without reaching /emit, /outputSnapshot or /searchIndex, which only get the pages that are written
+  {
+    const output::discarded_pass pass(ss);
+    process_all();
+  }
+  RecordRenderOrder();
+
+  std::set<std::string> selection;
+  auto select = [&](const auto& types, std::string_view ns) {
+    for (auto const& t : types) {
+      if (filter.Matches(ns, t.TypeName())) {
+        selection.insert(string(ns) + "." + string(t.TypeName()));
+      }
+    }
+  };
+  for (auto const& namespaceEntry : cache->namespaces()) {
+    if (namespaceEntry.first._Starts_with("Windows.")) continue;
+    const auto& ns = namespaceEntry.second;
+    select(ns.enums, namespaceEntry.first);
+    select(ns.classes, namespaceEntry.first);
+    select(ns.interfaces, namespaceEntry.first);
+    select(ns.structs, namespaceEntry.first);
+    select(ns.delegates, namespaceEntry.first);
+  }
+  if (!opts->withDependencies) return selection;
+
+  // the closure: a type comes in when a selected type refers to it or implements it
+  auto selected = [&selection](const TypeDef& t) {
+    return selection.find(string(t.TypeNamespace()) + "." + string(t.TypeName())) != selection.end();
+  };
+  for (bool grew = true; grew;) {
+    grew = false;
+    for (const auto& [ns, types] : references) {
+      if (string_view(ns)._Starts_with("Windows.")) continue;
+      for (const auto& [typeName, referrers] : types) {
+        const auto name = ns + "." + typeName;
+        if (selection.find(name) == selection.end() && std::any_of(referrers.begin(), referrers.end(), selected)) {
+          selection.insert(name);
+          grew = true;
+        }
+      }
+    }
+    for (auto const& namespaceEntry : cache->namespaces()) {
+      if (namespaceEntry.first._Starts_with("Windows.")) continue;
+      for (auto const& interfaceEntry : namespaceEntry.second.interfaces) {
+        const auto name = namespaceEntry.first + "." + string(interfaceEntry.TypeName());
+        const auto implementations = interfaceImplementations.find(string(interfaceEntry.TypeName()));
+        if (selection.find(name) == selection.end() && implementations != interfaceImplementations.end() &&
+          std::any_of(implementations->second.begin(), implementations->second.end(), selected)) {
+          selection.insert(name);
+          grew = true;
+        }
+      }
+    }
+  }
+  return selection;
+}
+
+void Program::RecordRenderOrder() {
+  renderOrder.clear();
+  for (auto const& namespaceEntry : cache->namespaces()) {
+    if (namespaceEntry.first._Starts_with("Windows.")) continue;
+    const auto types = select_types(namespaceEntry.second);
+    for (const auto* kind : { &types.enums, &types.classes, &types.interfaces, &types.structs, &types.delegates }) {
+      for (auto const& t : *kind) {
+        renderOrder.emplace(namespaceEntry.first + "." + string(t.TypeName()), static_cast<uint32_t>(renderOrder.size()));
+      }
+    }
+  }
+}
+
+bool Program::RenderedBefore(const TypeDef& type, const TypeDef& other) const {
+  if (renderOrder.empty()) return true;
+  const auto a = renderOrder.find(string(type.TypeNamespace()) + "." + string(type.TypeName()));
+  const auto b = renderOrder.find(string(other.TypeNamespace()) + "." + string(other.TypeName()));
+  return a != renderOrder.end() && b != renderOrder.end() && a->second < b->second;
+}
+
+incremental_state Program::CollectState() {
+  // a type's inherited members change with its ancestors, which the state doesn't track
+  if (spill || opts->inheritedMembers || ss.package || ss.snapshot || ss.search || ss.links || ss.store || ss.html) {
+    throw std::invalid_argument("/incremental only writes the pages that changed, so it can't be combined with /streaming, "
+      "/inheritedMembers, /outputBundle, /outputArchive, /outputSnapshot, /searchIndex, /checkLinks, /contentStore or /html");
   }
+  ss.state = std::make_unique<incremental_state>(OutputFingerprint());
+  {
+    // /emit gets the records of the pages that are written, in the pass after this one
+    const output::discarded_pass pass(ss);
+    try {
+      process_all();
+    }
+    catch (...) {
+      ss.state.reset();
+      throw;
+    }
+  }
+  RecordRenderOrder();
+  auto state = std::move(*ss.state);
+  ss.state.reset();
+
+  // the back-reference lists, now that every type has been through
+  for (const auto& [ns, types] : references) {
+    for (const auto& [typeName, referrers] : types) {
+      const auto type = state.types.find(ns + "." + typeName);
+      if (type == state.types.end()) continue;
+      for (const auto& r : referrers) {
+        type->second.referrers.push_back(string(r.TypeNamespace()) + "." + string(r.TypeName()));
+      }
+      std::sort(type->second.referrers.begin(), type->second.referrers.end());
+    }
+  }
+  for (auto const& namespaceEntry : cache->namespaces()) {
+    for (auto const& interfaceEntry : namespaceEntry.second.interfaces) {
+      const auto implementations = interfaceImplementations.find(string(interfaceEntry.TypeName()));
+      const auto type = state.types.find(namespaceEntry.first + "." + string(interfaceEntry.TypeName()));
+      if (implementations == interfaceImplementations.end() || type == state.types.end()) continue;
+      for (const auto& i : implementations->second) {
+        type->second.implementers.push_back(string(i.TypeNamespace()) + "." + string(i.TypeName()));
+      }
+      std::sort(type->second.implementers.begin(), type->second.implementers.end());
+    }
+  }
+  return state;
+}
+
+void Program::OpenOutputs() {
+  if (!opts->outputBundle.empty() && !opts->outputArchive.empty()) {
+    throw std::invalid_argument("/outputBundle and /outputArchive can't be used together");
+  }
+  if (!opts->outputBundle.empty()) {
+    ss.package = std::make_unique<bundle_writer>(filesystem::u8path(opts->outputBundle));
+  }
+  else if (!opts->outputArchive.empty()) {
+    if (opts->streaming) {
+      // archive entries can't be appended to once written, and streaming appends back-references at the very end
+      throw std::invalid_argument("/outputArchive can't be combined with /streaming; use /outputBundle instead");
+    }
+    ss.package = std::make_unique<archive_writer>(filesystem::u8path(opts->outputArchive));
+  }
+  if (opts->fanOut == "namespace") {
+    ss.layout = page_layout::byNamespace;
+  }
+  else if (opts->fanOut == "hash") {
+    ss.layout = page_layout::byHash;
+  }
+  else if (!opts->fanOut.empty()) {
+    throw std::invalid_argument("Unsupported /fanOut layout " + opts->fanOut + "; use namespace or hash");
+  }
+  if (!opts->contentStore.empty()) {
+    if (ss.package || opts->precompress) {
+      throw std::invalid_argument("/contentStore can't be combined with /outputBundle, /outputArchive or /precompress");
+    }
+    ss.store = std::make_unique<content_store>(filesystem::u8path(opts->contentStore));
+  }
+  if (opts->html) {
+    if (ss.package || ss.store || opts->streaming || opts->atomicWrites || opts->precompress) {
+      // the pages are converted once their namespace is done; streaming appends to them at the very end
+      throw std::invalid_argument("/html can't be combined with /streaming, /outputBundle, /outputArchive, /contentStore, /atomicWrites or /precompress");
+    }
+    ss.html = std::make_unique<html_site>(filesystem::u8path(opts->outputDirectory), opts->fileSuffix);
+  }
+  if (opts->atomicWrites && !ss.package) {
+    ss.staged = std::make_unique<staged_files>();
+  }
+  if (opts->precompress && !ss.package) {
+    ss.siblings = std::make_unique<gzip_siblings>();
+  }
+  if (!opts->emit.empty()) {
+    if (opts->emit != "ndjson") {
+      throw std::invalid_argument("Unsupported /emit format " + opts->emit + "; the only format is ndjson");
+    }
+    std::shared_ptr<std::ostream> records;
+    if (opts->emitFile.empty()) {
+      _setmode(_fileno(stdout), _O_BINARY); // one \n per record, even on Windows
+      records = std::shared_ptr<std::ostream>(&cout, [](std::ostream*) {});
+    }
+    else {
+      records = std::make_shared<ofstream>(filesystem::u8path(opts->emitFile), ios::binary | ios::trunc);
+    }
+    ss.records = std::make_unique<ndjson_writer>(records);
+  }
+  if (!opts->outputSnapshot.empty()) {
+    ss.snapshot = std::make_unique<snapshot_writer>(filesystem::u8path(opts->outputSnapshot));
+  }
+  if (opts->searchIndex) {
+    ss.search = std::make_unique<search_index>();
+  }
+  if (opts->checkLinks) {
+    ss.links = std::make_unique<link_checker>();
+  }
+}
+
+void Program::CloseOutputs() {
+  if (ss.links) {
+    const auto broken = ss.links->Check();
+    for (const auto& b : broken) {
+      cerr << b.page << (b.member.empty() ? "" : " (" + b.member + ")") << ": " << b.reason << ": " << b.target << "\n";
+    }
+    cerr << "Checked " << ss.links->LinkCount() << " links, " << broken.size() << " broken\n";
+    brokenLinks += broken.size();
+    ss.links.reset();
+  }
+  if (ss.search) {
+    ss.search->Write(*ss.OpenFile(filesystem::path(opts->outputDirectory) / "search-index.json"));
+    ss.search.reset();
+  }
+  if (ss.html) {
+    ss.html->Wait();
+    cout << "Wrote " << ss.html->Written() << " HTML pages\n";
+    ss.html.reset();
+  }
+  if (ss.staged) {
+    ss.staged->Commit();
+    cout << "Wrote " << ss.staged->Written() << " files, " << ss.staged->Unchanged() << " unchanged\n";
+    ss.staged.reset();
+  }
+  if (ss.store) {
+    ss.store->Close(filesystem::path(opts->outputDirectory) / "front-matter.json");
+    cout << "Stored " << ss.store->Stored() << " new page bodies, " << ss.store->Shared() << " shared with other versions\n";
+    ss.store.reset();
+  }
+  if (ss.package) {
+    ss.package->Close();
+    ss.package.reset();
+  }
+  if (ss.siblings) {
+    ss.siblings->Wait();
+    ss.siblings.reset();
+  }
+  if (ss.records) {
+    ss.records->Flush();
+    ss.records.reset();
+  }
+  if (ss.snapshot) {
+    ss.snapshot->Close();
+    ss.snapshot.reset();
+  }
+}
+
+MemberType MemberTypeFromId(uint32_t id) {
+  switch (id) {
+  case 'F': return MemberType::Field;
+  case 'P': return MemberType::Property;
+  case 'T': return MemberType::Type;
+  case 'M': return MemberType::Method;
+  case 'E': return MemberType::Event;
+  default:
+    throw std::invalid_argument("unexpected member type in snapshot");
+  }
+}
+
+model_record RecordFromSnapshot(const snapshot_view& snapshot, const snapshot_format::type_entry& type, const snapshot_format::member_entry* member = nullptr) {
+  using namespace snapshot_format;
+  model_record record;
+  record.ns = snapshot[type.ns];
+  record.type = snapshot[type.name];
+  auto common = [&](model_kind kind, uint32_t flags, str deprecated, str defaultValue, str doc) {
+    record.kind = kind;
+    record.experimental = (flags & flag::experimental) != 0;
+    record.isStatic = (flags & flag::isStatic) != 0;
+    record.readonly = (flags & flag::readonly) != 0;
+    record.deprecated = snapshot[deprecated];
+    record.defaultValue = snapshot[defaultValue];
+    record.doc = snapshot[doc];
+  };
+  if (!member) {
+    common(type.kind, type.flags, type.deprecated, type.defaultValue, type.doc);
+    record.valueType = snapshot[type.extends];
+    for (const auto& name : snapshot.Names().slice(type.implements)) {
+      record.implements.emplace_back(snapshot[name]);
+    }
+    return record;
+  }
+  common(member->kind, member->flags, member->deprecated, member->defaultValue, member->doc);
+  record.member = snapshot[member->name];
+  record.valueType = snapshot[member->valueType];
+  record.signature = snapshot[member->signature];
+  record.value = member->value;
+  for (const auto& p : snapshot.Parameters().slice(member->parameters)) {
+    record.parameters.push_back({ string(snapshot[p.name]), string(snapshot[p.type]), (p.flags & flag::out) != 0 });
+  }
+  return record;
+}
+
+int Program::RenderSnapshot() {
+  const mapped_file file(filesystem::u8path(opts->fromSnapshot));
+  const snapshot_view snapshot(file.Contents().data(), file.Contents().size());
+  OpenOutputs();
+
+  // Same order as a regular run: the pages, the namespace's index, then the back-references
+  const auto types = snapshot.Types();
+  for (const auto& ns : snapshot.Namespaces()) {
+    currentNamespace = snapshot[ns.name];
+    ss.StartNamespace(currentNamespace);
+    index_entries index;
+    for (const auto& type : types.slice(ns.types)) {
+      const auto name = snapshot[type.name];
+      {
+        const auto t = ss.StartType(name, ToString(type.kind));
+        if (ss.Modeling()) {
+          // replay the model for /emit, /searchIndex or another snapshot
+          auto record = RecordFromSnapshot(snapshot, type);
+          ss.Record(record);
+          for (const auto& member : snapshot.Members().slice(type.members)) {
+            record = RecordFromSnapshot(snapshot, type, &member);
+            ss.Record(record);
+          }
+        }
+        ss << snapshot[type.page];
+      }
+      index[type.kind].push_back(name);
+    }
+    for (const auto& entry : snapshot.Xml().slice(ns.xml)) {
+      if (ss.snapshot) {
+        ss.snapshot->AddXmlMember(static_cast<char>(entry.memberType), snapshot[entry.name], snapshot[entry.summary]);
+      }
+      ss.currentXml.AddMember(MemberTypeFromId(entry.memberType), string(snapshot[entry.name]), string(snapshot[entry.summary]));
+    }
+    write_index(currentNamespace, index);
+
+    if (opts->printReferenceGraph) std::cout << "Reference graph:\n";
+    for (const auto& entry : snapshot.Referenced().slice(ns.referenced)) {
+      std::vector<std::string> referrers;
+      for (const auto& r : snapshot.Names().slice(entry.referrers)) {
+        referrers.emplace_back(snapshot[r]);
+      }
+      write_referenced_by(currentNamespace, snapshot[entry.type], referrers);
+    }
+    ss.EndNamespace();
+  }
+  CloseOutputs();
+  return brokenLinks == 0 ? 0 : 1;
+}
+
+void Program::process_all() {
+  for (auto const& namespaceEntry : cache->namespaces()) {
+    if (namespaceEntry.first._Starts_with("Windows.")) continue;
+    currentNamespace = namespaceEntry.first;
+    const auto& ns = namespaceEntry.second;
+    for (auto const& enumEntry : ns.enums) {
+      if (!opts->outputExperimental && IsExperimental(enumEntry)) continue;
+      process_enum(ss, enumEntry);
+    }
+    for (auto const& classEntry : ns.classes) {
+      if (!opts->outputExperimental && IsExperimental(classEntry)) continue;
+      process_class<section_layout>(ss, classEntry, "class");
+    }
+    for (auto const& interfaceEntry : ns.interfaces) {
+      if (shouldSkipInterface(interfaceEntry)) continue;
+      process_class<section_layout>(ss, interfaceEntry, "interface");
+    }
+    for (auto const& structEntry : ns.structs) {
+      if (!opts->outputExperimental && IsExperimental(structEntry)) continue;
+      process_struct<section_layout>(ss, structEntry);
+    }
+    for (auto const& delegateEntry : ns.delegates) {
+      if (!opts->outputExperimental && IsExperimental(delegateEntry)) continue;
+      process_delegate(ss, delegateEntry);
+    }
+  }
+}
+
+bool IsSnapshot(const std::string& path) {
+  char magic[sizeof(snapshot_format::magic)]{};
+  ifstream file(filesystem::u8path(path), ios::binary);
+  file.read(magic, sizeof(magic));
+  return file && memcmp(magic, snapshot_format::magic, sizeof(magic)) == 0;
+}
+
+api_model Program::LoadModel() {
+  api_model model;
+  if (!opts->fromSnapshot.empty()) {
+    const mapped_file file(filesystem::u8path(opts->fromSnapshot));
+    const snapshot_view snapshot(file.Contents().data(), file.Contents().size());
+    for (const auto& type : snapshot.Types()) {
+      model.Add(RecordFromSnapshot(snapshot, type));
+      for (const auto& member : snapshot.Members().slice(type.members)) {
+        model.Add(RecordFromSnapshot(snapshot, type, &member));
+      }
+    }
+    return model;
+  }
+
+  cache = std::make_unique<winmd::reader::cache>(std::vector<std::string>{ getWindowsWinMd(), opts->winMDPath });
+  ss.model = std::make_unique<api_model>();
+  ss.Redirect(std::make_shared<std::ostream>(nullptr));
+  process_all();
+  ss.Redirect(nullptr);
+  model = std::move(*ss.model);
+  ss.model.reset();
+  return model;
+}
+
+int Program::Diff() {
+  // The older version gets a Program of its own, so its metadata and references stay out of ours
+  Program older;
+  older.opts = std::make_unique<options>(*opts);
+  older.opts->winMDPath = opts->diffFrom;
+  older.opts->fromSnapshot = IsSnapshot(opts->diffFrom) ? opts->diffFrom : "";
+  const auto before = older.LoadModel();
+  const auto after = LoadModel();
+
+  // Loading is the slow part; matching by name and comparing hashes only looks closer at what changed
+  const auto start = chrono::steady_clock::now();
+  const auto changes = DiffApis(before, after);
+  const auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+
+  const auto fromName = filesystem::u8path(opts->diffFrom).filename().u8string();
+  const auto toName = filesystem::u8path(opts->fromSnapshot.empty() ? opts->winMDPath : opts->fromSnapshot).filename().u8string();
+  const filesystem::path outputDirectory(opts->outputDirectory);
+  WriteChangelogMarkdown(*ss.OpenFile(outputDirectory / "api-changes.md"), changes, fromName, toName);
+  WriteChangelogJson(*ss.OpenFile(outputDirectory / "api-changes.json"), changes, fromName, toName);
+
+  size_t counts[3]{};
+  for (const auto& c : changes) {
+    counts[static_cast<int>(c.change)]++;
+  }
+  cout << counts[0] << " added, " << counts[1] << " removed, " << counts[2] << " changed; compared "
+    << before.Size() << " and " << after.Size() << " entities in " << elapsed.count() << "ms\n";
   return 0;
 }
 
-void Program::write_index(string_view namespaceName, const cache::namespace_members& ns) {
-  ofstream index(ss.GetFileForType("index"));
+int Program::MergeShards() {
+  const auto count = static_cast<uint32_t>(std::stoul(opts->mergeShards));
+  shard_data data;
+  data.Read(opts->outputDirectory, count);
+  if (data.fingerprint != OutputFingerprint()) {
+    throw std::invalid_argument("The shards were rendered with different page options than this merge");
+  }
+  OpenOutputs();
+  RequirePlainOutput("/mergeShards");
+
+  // Everything below follows what a single process does at the end of each namespace. It only sees the types
+  // rendered so far: an interface lists the implementers rendered before it, and a type lists the referrers from
+  // its own namespace and the namespaces before it.
+  std::map<std::string, std::vector<const shard_data::implementation*>> implementations;
+  for (const auto& i : data.implementations) {
+    implementations[i.iface].push_back(&i);
+  }
+  std::map<std::string, uint32_t> namespaceOrder;
+  for (uint32_t i = 0; i < data.namespaces.size(); i++) {
+    namespaceOrder[data.namespaces[i]] = i;
+  }
+  std::map<std::string, std::map<std::string, std::set<std::pair<std::string, std::string>>>> references;
+  for (const auto& r : data.references) {
+    const auto ns = namespaceOrder.find(r.ns);
+    if (ns == namespaceOrder.end() || namespaceOrder.at(r.referrerNs) > ns->second) continue;
+    references[r.ns][r.type].emplace(r.referrerNs, r.referrer);
+  }
 
-  const auto apiVersionPrefix = (opts->apiVersion != "") ? ("version-" + opts->apiVersion + "-") : "";
+  size_t next = 0;
+  for (uint32_t n = 0; n < data.namespaces.size(); n++) {
+    currentNamespace = data.namespaces[n];
+    ss.StartNamespace(currentNamespace);
+    index_entries index;
+    for (; next < data.types.size() && data.types[next].ns == n; next++) {
+      const auto& type = data.types[next];
+      *ss.currentXml.out << type.xml;
+      index[type.kind].push_back(type.name);
+      if (type.kind != model_kind::Interface) continue;
+
+      string implementedBy;
+      const auto implementers = implementations.find(type.name);
+      if (implementers != implementations.end() && implementers->second.front()->seq < type.seq) {
+        ss.LinkFrom(type.name);
+        implementedBy = "Implemented by: \n";
+        for (const auto* i : implementers->second) {
+          if (i->seq > type.seq) break;
+          implementedBy += "- " + format.typeToMarkdown(i->ns, i->name, true) + "\n";
+        }
+      }
+      const auto path = ss.GetFileForType(type.name);
+      ostringstream page;
+      page << ifstream(path).rdbuf();
+      auto text = page.str();
+      const auto marker = text.find(shard_writer::implementedByMarker);
+      if (marker == string::npos) {
+        throw runtime_error("The page of " + currentNamespace + "." + type.name + " wasn't written by a shard");
+      }
+      text.replace(marker, shard_writer::implementedByMarker.length(), implementedBy);
+      *ss.OpenFile(path) << text;
+    }
+    write_index(currentNamespace, index);
 
-  index << R"(---
-id: )" << apiVersionPrefix << R"(Native-API-Reference
-title: namespace )" << namespaceName << R"(
-sidebar_label: Full reference
-)";
+    if (opts->printReferenceGraph) std::cout << "Reference graph:\n";
+    for (const auto& [typeName, referrers] : references[currentNamespace]) {
+      std::vector<std::string> sorted;
+      for (const auto& r : referrers) {
+        sorted.push_back(r.second);
+      }
+      std::sort(sorted.begin(), sorted.end());
+      write_referenced_by(currentNamespace, typeName, sorted);
+    }
+    ss.EndNamespace();
+  }
+  CloseOutputs();
 
-  if (opts->apiVersion != "") {
-    index << "original_id: " << "Native-API-Reference" << "\n";
+  for (const auto& file : data.files) {
+    filesystem::remove(file);
   }
+  cout << "Merged " << count << " shards: " << data.types.size() << " types in " << data.namespaces.size() << " namespaces\n";
+  return 0;
+}
 
-  index << R"(
----
+int Program::Watch(const std::string& windowsWinMd) {
+  const auto winmd = filesystem::absolute(opts->winMDPath);
+  // Render from a private copy so the build can rewrite the winmd while we hold it mapped. It goes in the temp
+  // directory rather than next to the docs, in a folder of its own for each output directory, so watchers of other
+  // output directories don't share it.
+  const auto outputDirectory = filesystem::absolute(opts->outputDirectory).lexically_normal().u8string();
+  const auto work = filesystem::temp_directory_path() / ("winmd2md-watch-" + to_string(std::hash<string>{}(outputDirectory)));
+  const auto snapshot = work / winmd.filename();
+  filesystem::create_directories(work);
+  // each change only re-renders the pages of the types whose metadata changed and of the types that list them
+  opts->incremental = true;
+
+  file_watcher watcher(winmd);
+  string previous;
+  for (bool first = true;; first = false) {
+    if (!first) watcher.WaitForChange();
+    const auto start = chrono::steady_clock::now();
+    try {
+      cache.reset();
+      string contents;
+      {
+        ifstream in(winmd, ios::binary);
+        ostringstream buffer;
+        buffer << in.rdbuf();
+        contents = buffer.str();
+      }
+      if (contents == previous) {
+        cout << winmd.filename().u8string() << ": no metadata changes\n";
+        continue;
+      }
+      ofstream(snapshot, ios::binary | ios::trunc).write(contents.data(), contents.size());
+      Regenerate(windowsWinMd, snapshot);
+      previous = std::move(contents);
+      const auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+      cout << winmd.filename().u8string() << ": regenerated in " << elapsed.count() << " ms\n";
+    }
+    catch (const exception& e) {
+      // options that can't be combined with /incremental show up on the first run
+      if (first) throw;
+      // a half-built winmd shouldn't stop the watcher; the next write will trigger another attempt
+      cerr << winmd.filename().u8string() << ": " << e.what() << "\n";
+    }
+  }
+}
 
-)";
+void Program::Regenerate(const std::string& windowsWinMd, const filesystem::path& winmd) {
+  references.clear();
+  interfaceImplementations.clear();
+  Generate({ windowsWinMd, winmd.u8string() });
+}
 
-  index << "## Enums" << "\n";
-  for (auto const& t : ns.enums) {
-    if (!opts->outputExperimental && IsExperimental(t)) continue;
-    index << link(t.TypeName()) << "\n";
+Program::renderer Program::SelectRenderer() const {
+  if (opts->propertiesAsTable) {
+    return opts->fieldsAsTable ? &Program::render<table_layout, table_layout> : &Program::render<table_layout, section_layout>;
   }
+  else {
+    return opts->fieldsAsTable ? &Program::render<section_layout, table_layout> : &Program::render<section_layout, section_layout>;
+  }
+}
 
-  index << "## Interfaces" << "\n";
-  for (auto const& t : ns.interfaces) {
-    if (!opts->outputExperimental && IsExperimental(t)) continue;
-    if (shouldSkipInterface(t)) continue;
-    index << link(t.TypeName()) << "\n";
+int Program::Serve(const std::vector<std::string>& files) {
+  cache = std::make_unique<winmd::reader::cache>(files);
+
+  // Render everything once into a discarded stream: a page lists the types that reference or implement it,
+  // and only the other types' pages can tell us that
+  ss.Redirect(std::make_shared<std::ostream>(nullptr));
+  process_all();
+
+  // Requests are one per line: an optional "md " or "xml " followed by Namespace.Type or Namespace.Type.Member.
+  // Replies are "ok <byte count>\n" followed by the fragment, or a single "error <message>\n" line.
+  _setmode(_fileno(stdout), _O_BINARY); // the byte counts have to match what the client reads
+  const auto renderRequest = SelectRenderer();
+  string line;
+  while (getline(cin, line)) {
+    string_view request = line;
+    if (request.empty()) continue;
+    bool xml = false;
+    if (request._Starts_with("xml ")) {
+      xml = true;
+      request.remove_prefix(4);
+    }
+    else if (request._Starts_with("md ")) {
+      request.remove_prefix(3);
+    }
+    try {
+      const auto text = (this->*renderRequest)(request, xml);
+      cout << "ok " << text.length() << "\n" << text;
+    }
+    catch (const exception& e) {
+      cout << "error " << e.what() << "\n";
+    }
+    cout.flush();
   }
+  return 0;
+}
 
-  index << "## Structs" << "\n";
-  for (auto const& t : ns.structs) {
-    if (!opts->outputExperimental && IsExperimental(t)) continue;
-    index << link(t.TypeName()) << "\n";
+template<typename PropertyLayout, typename FieldLayout>
+string Program::render(string_view name, bool xml) {
+  // Namespace.Type, or else Namespace.Type.Member
+  const auto dot = name.rfind('.');
+  if (dot == string_view::npos) {
+    throw std::invalid_argument("expected a namespace-qualified name: " + string(name));
+  }
+  TypeDef type = cache->find(name.substr(0, dot), name.substr(dot + 1));
+  string_view member;
+  if (!type) {
+    const auto typeName = name.substr(0, dot);
+    const auto typeDot = typeName.rfind('.');
+    if (typeDot != string_view::npos) {
+      type = cache->find(typeName.substr(0, typeDot), typeName.substr(typeDot + 1));
+      member = name.substr(dot + 1);
+    }
+  }
+  if (!type || (!opts->outputExperimental && IsExperimental(type))) {
+    throw std::invalid_argument("unknown type or member: " + string(name));
   }
 
-  index << "## Classes" << "\n";
+  currentNamespace = type.TypeNamespace();
+  const auto markdown = std::make_shared<ostringstream>();
+  const auto fragment = std::make_shared<ostringstream>();
+  ss.currentXml = intellisense_xml(currentNamespace, fragment, true);
+
+  if (member.empty()) {
+    ss.Redirect(markdown);
+    const auto& ns = cache->namespaces().at(type.TypeNamespace());
+    auto contains = [&type](const std::vector<TypeDef>& types) { return std::find(types.cbegin(), types.cend(), type) != types.cend(); };
+    if (contains(ns.enums)) {
+      process_enum(ss, type);
+    }
+    else if (contains(ns.structs)) {
+      process_struct<FieldLayout>(ss, type);
+    }
+    else if (contains(ns.delegates)) {
+      process_delegate(ss, type);
+    }
+    else if (contains(ns.interfaces)) {
+      process_class<PropertyLayout>(ss, type, "interface");
+    }
+    else {
+      process_class<PropertyLayout>(ss, type, "class");
+    }
+
+    const auto& backReferences = references[currentNamespace];
+    const auto referrers = backReferences.find(string(type.TypeName()));
+    if (referrers != backReferences.end()) {
+      std::vector<std::string> sorted;
+      std::for_each(referrers->second.begin(), referrers->second.end(), [&sorted](auto& x) { sorted.push_back(string(x.TypeName())); });
+      std::sort(sorted.begin(), sorted.end());
+      print_referenced_by(*markdown, currentNamespace, type.TypeName(), sorted);
+    }
+  }
+  else {
+    if (type.is_enum()) {
+      throw std::invalid_argument("enum values are rendered as part of their enum: " + string(name));
+    }
+    // Same heading level as on the type's page, under Properties/Methods/Events/Fields
+    ss.Redirect(markdown, 2);
+    bool found = false;
+    for (auto const& prop : type.PropertyList()) {
+      if (prop.Name() != member || (!opts->outputExperimental && IsExperimental(prop))) continue;
+      process_property<PropertyLayout>(ss, prop);
+      found = true;
+    }
+    for (auto const& method : type.MethodList()) {
+      if (method.SpecialName() || method.Name() != member || (!opts->outputExperimental && IsExperimental(method))) continue;
+      process_method(ss, method);
+      found = true;
+    }
+    for (auto const& evt : type.EventList()) {
+      if (evt.Name() != member || (!opts->outputExperimental && IsExperimental(evt))) continue;
+      process_event(ss, type, evt);
+      found = true;
+    }
+    for (auto const& field : type.FieldList()) {
+      if (field.Name() != member) continue;
+      process_field<FieldLayout>(ss, field);
+      found = true;
+    }
+    if (!found) {
+      throw std::invalid_argument("unknown type or member: " + string(name));
+    }
+  }
 
-  for (auto const& t : ns.classes) {
-    if (!opts->outputExperimental && IsExperimental(t)) continue;
-    index << link(t.TypeName()) << "\n";
+  ss.currentXml = intellisense_xml();
+  return xml ? fragment->str() : markdown->str();
+}
+
+void Program::write_index(string_view namespaceName, const index_entries& entries) {
+  if (ss.pageFilter && !ss.pageFilter(namespaceName, "index")) return;
+  const auto directory = ss.GetIndexDirectory(namespaceName);
+  const auto apiVersionPrefix = (opts->apiVersion != "") ? ("version-" + opts->apiVersion + "-") : "";
+
+  auto startPage = [&](string_view name, string_view id, string_view title, string_view sidebarLabel) {
+    auto file = ss.OpenFile(ss.GetFileForType(name, namespaceName));
+    *file << "---\nid: " << apiVersionPrefix << id << "\ntitle: " << title << "\nsidebar_label: " << sidebarLabel << "\n";
+    if (opts->apiVersion != "") {
+      *file << "original_id: " << id << "\n";
+    }
+    *file << "\n---\n\n";
+    return file;
+  };
+  auto writeLinks = [&](std::ostream& page, string_view pageName, string_view heading, const std::vector<std::string_view>& types) {
+    for (const auto& t : types) {
+      page << link(t, ss.GetLinkToType(t, directory, namespaceName)) << "\n";
+      if (ss.links) {
+        ss.links->AddLink(string(namespaceName) + " " + string(pageName), heading, t);
+      }
+    }
+  };
+
+  constexpr std::pair<model_kind, std::string_view> sections[] = {
+    { model_kind::Enum, "Enums" },
+    { model_kind::Interface, "Interfaces" },
+    { model_kind::Struct, "Structs" },
+    { model_kind::Class, "Classes" },
+    { model_kind::Delegate, "Delegates" },
+  };
+  size_t total = 0;
+  for (const auto& [kind, types] : entries) {
+    total += types.size();
+  }
+  const auto title = "namespace " + string(namespaceName);
+  const auto index = startPage("index", "Native-API-Reference", title, "Full reference");
+  if (opts->indexPageSize == 0 || total <= opts->indexPageSize) {
+    for (const auto& [kind, heading] : sections) {
+      *index << "## " << heading << "\n";
+      const auto types = entries.find(kind);
+      if (types == entries.end()) continue;
+      writeLinks(*index, "index", heading, types->second);
+    }
+    return;
   }
 
-  index << "## Delegates" << "\n";
-  for (auto const& t : ns.delegates) {
-    if (!opts->outputExperimental && IsExperimental(t)) continue;
-    index << link(t.TypeName()) << "\n";
+  // /indexPageSize: the index only lists the pages of each kind, which list the types sorted by name, one page per
+  // initial letter when a kind has more types than fit on a page
+  for (const auto& [kind, heading] : sections) {
+    *index << "## " << heading << "\n";
+    const auto types = entries.find(kind);
+    if (types == entries.end()) continue;
+    auto sorted = types->second;
+    std::sort(sorted.begin(), sorted.end());
+
+    std::string kindName(heading);
+    std::transform(kindName.begin(), kindName.end(), kindName.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+    std::map<char, std::vector<std::string_view>> pages;
+    if (sorted.size() <= opts->indexPageSize) {
+      pages[0] = std::move(sorted);
+    }
+    else {
+      for (const auto& t : sorted) {
+        const auto initial = static_cast<unsigned char>(t.front());
+        pages[std::isalpha(initial) ? static_cast<char>(std::toupper(initial)) : '_'].push_back(t);
+      }
+    }
+    for (const auto& [letter, page] : pages) {
+      auto name = "index-" + kindName;
+      auto label = string(heading);
+      if (letter != 0) {
+        name += "-" + string(1, static_cast<char>(std::tolower(letter)));
+        label += " (" + string(1, letter) + ")";
+      }
+      *index << link(label, name) << " (" << page.size() << ")\n";
+      const auto file = startPage(name, name, title + ": " + label, label);
+      writeLinks(*file, name, heading, page);
+    }
   }
 }
 
@@ -6,6 +6,17 @@
 #include "Options.h"
 #include "output.h"
 #include "Format.h"
+#include "Inheritance.h"
+#include "ReferenceSpill.h"
+#include "Shard.h"
+#include "XrefMap.h"
+
+/// <summary>
+/// Layout policies for member lists (/propsAsTable, /fieldsAsTable). The layout is picked once per run in
+/// SelectLayout, and each combination gets its own instantiation of the page emitters.
+/// </summary>
+struct section_layout { static constexpr bool AsTable(const options&) { return false; } };
+struct table_layout { static constexpr bool AsTable(const options&) { return true; } };
 
 struct Program {
   std::string currentNamespace;
@@ -24,34 +35,121 @@ struct Program {
 
   // map of namespaces N -> (map of types T in N -> (list of types that reference T))
   std::map<std::string, std::map<std::string, std::vector<winmd::reader::TypeDef>>> references{};
+  // in streaming mode (/streaming) back-references go here instead of references, and are written after the last namespace
+  std::unique_ptr<reference_spill> spill{ nullptr };
+  // with /shard, the partial file for the merge; this process only renders the types the shard owns
+  std::unique_ptr<shard_writer> shard{ nullptr };
+  // built as pages ask for it, and kept until the WinMDs are loaded again
+  std::unique_ptr<inheritance_graph> inheritance{ nullptr };
+  // /xrefMap: the docs of types from WinMDs that aren't loaded
+  xref_map xrefs;
   output ss;
+  // broken links found by /checkLinks; any make Process return 1
+  size_t brokenLinks = 0;
   friend class UnitTests;
 
   Program() : ss(this), format(this) {}
 private:
+  template<typename PropertyLayout>
   void process_class(output& ss, const winmd::reader::TypeDef& type, std::string kind);
   void process_enum(output& ss, const winmd::reader::TypeDef& type);
+  template<typename PropertyLayout>
   void process_property(output& ss, const winmd::reader::Property& prop);
   void process_method(output& ss, const winmd::reader::MethodDef& method, std::string_view realName = "");
+  template<typename FieldLayout>
   void process_field(output& ss, const winmd::reader::Field& field);
+  template<typename FieldLayout>
   void process_struct(output& ss, const winmd::reader::TypeDef& type);
   void process_delegate(output& ss, const winmd::reader::TypeDef& type);
+  void process_event(output& ss, const winmd::reader::TypeDef& type, const winmd::reader::Event& evt);
+  // /inheritedMembers: the members of the base classes and required interfaces that the type doesn't declare itself
+  void print_inherited_members(output& ss, const winmd::reader::TypeDef& type);
+  std::optional<inheritance_graph::type_info> InheritanceOf(std::string_view name);
+  template<typename PropertyLayout, typename FieldLayout>
   void process(std::string_view namespaceName, const winmd::reader::cache::namespace_members& ns);
+  // /shard: renders this shard's types of the namespace, and numbers all of them
+  template<typename PropertyLayout, typename FieldLayout>
+  void process_shard(std::string_view namespaceName, const winmd::reader::cache::namespace_members& ns);
+
+  // the types of a namespace that get pages, in the cache's order; filtered once for both the pages and the index
+  struct namespace_types {
+    std::vector<winmd::reader::TypeDef> enums;
+    std::vector<winmd::reader::TypeDef> classes;
+    std::vector<winmd::reader::TypeDef> interfaces;
+    std::vector<winmd::reader::TypeDef> structs;
+    std::vector<winmd::reader::TypeDef> delegates;
+    std::map<model_kind, std::vector<std::string_view>> Index() const;
+  };
+  namespace_types select_types(const winmd::reader::cache::namespace_members& ns);
 
-  void write_index(std::string_view namespaceName, const winmd::reader::cache::namespace_members& ns);
+  using namespace_processor = void (Program::*)(std::string_view, const winmd::reader::cache::namespace_members&);
+  namespace_processor SelectLayout() const;
+  // The Benchmark project's baseline: the emitters that read the layout flags in every member loop, as they did before
+  // the layouts became template parameters. The emitters are defined in Program.cpp, so only it can instantiate them.
+  bool runtimeLayouts = false;
+  friend struct layout_benchmark;
+
+  // the types listed on a namespace's index page, by kind
+  using index_entries = std::map<model_kind, std::vector<std::string_view>>;
+  void write_index(std::string_view namespaceName, const index_entries& entries);
+  void write_referenced_by(std::string_view namespaceName, std::string_view typeName, const std::vector<std::string>& sortedReferrers);
+  void print_referenced_by(std::ostream& md, std::string_view namespaceName, std::string_view typeName, const std::vector<std::string>& sortedReferrers);
 
   void AddReference(const winmd::reader::TypeSig& prop, const winmd::reader::TypeDef& owningType);
   void AddReference(const winmd::reader::coded_index<winmd::reader::TypeDefOrRef>& classTypeDefOrRef, const winmd::reader::TypeDef& owningType);
 
   std::string getWindowsWinMd();
+  void Generate(const std::vector<std::string>& files);
+  // the options that change how pages look, for telling whether two runs' output can be combined
+  std::string OutputFingerprint() const;
+  // throws if an option that needs every page in this process, or pages anywhere but the output directory, is set
+  void RequirePlainOutput(std::string_view option) const;
+  // /mergeShards: combines the partial files of the /shard runs into what one process would have written
+  int MergeShards();
+  // /namespace, /type, /withDependencies: the qualified names of the types whose pages get written
+  std::set<std::string> SelectTypes(const type_filter& filter);
+  // /incremental: the page hashes and back-reference lists, from rendering everything once into a discarded stream
+  incremental_state CollectState();
+  // After a full pass (/incremental, /namespace, /type), references and interfaceImplementations hold every type's
+  // back-references, while a full run lists only the referrers and implementers rendered before the list is written.
+  // renderOrder is each type's place in a full run, so the lists written by the second pass match a full run's.
+  void RecordRenderOrder();
+  bool RenderedBefore(const winmd::reader::TypeDef& type, const winmd::reader::TypeDef& other) const;
+  std::map<std::string, uint32_t> renderOrder;
+  // the bundle, archive or .gz siblings that pages go into, shared by Generate and RenderSnapshot
+  void OpenOutputs();
+  void CloseOutputs();
+  // /fromSnapshot: writes the pages back out of a snapshot without loading any metadata
+  int RenderSnapshot();
+  int Watch(const std::string& windowsWinMd);
+  // /watch: one /incremental run over the current copy of the WinMD, after the last one
+  void Regenerate(const std::string& windowsWinMd, const std::filesystem::path& winmd);
+  // /diffFrom: compares the API of the WinMD (or /fromSnapshot) with an older WinMD or snapshot
+  int Diff();
+  // the model of every type and member, from /fromSnapshot or else by rendering the WinMD into a discarded stream
+  api_model LoadModel();
+  // runs every type through its process_* emitter once, into whatever ss is redirected to
+  void process_all();
+
+  // /serve: answers single-type and single-member requests on stdin/stdout from metadata loaded once
+  int Serve(const std::vector<std::string>& files);
+  template<typename PropertyLayout, typename FieldLayout>
+  std::string render(std::string_view name, bool xml);
+  using renderer = std::string(Program::*)(std::string_view, bool);
+  renderer SelectRenderer() const;
   template<typename IT>
   bool shouldSkipInterface(const IT /*TypeDef*/& interfaceEntry);
 
-  template<typename T, typename F = nullptr_t>
-  void PrintOptionalSections(MemberType mt, output& ss, const T& type, std::optional<F> fallback_type = std::nullopt);
+  template<MemberType mt, typename T, typename F = nullptr_t>
+  void PrintOptionalSections(output& ss, const T& type, std::optional<F> fallback_type = std::nullopt);
 
   template<typename T, typename Converter>
   std::string GetDeprecated(const T& type, Converter converter);
 
+  // /emit, /outputSnapshot: a model record with the experimental flag, deprecation message, default value and doc string
+  // filled in, and references resolved to qualified names
+  template<typename T, typename F = nullptr_t>
+  model_record MakeRecord(model_kind kind, const winmd::reader::TypeDef& type, std::string_view member, const T& item, std::optional<F> fallback_type = std::nullopt);
+
   Formatter format;
 };
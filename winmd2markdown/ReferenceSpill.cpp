@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <queue>
+#include <stdexcept>
+
+#include "ReferenceSpill.h"
+
+using namespace std;
+
+namespace {
+  // Each string in the edge file is a 16-bit length followed by its bytes
+  void WriteString(ostream& out, string_view s) {
+    if (s.length() > UINT16_MAX) {
+      throw std::length_error("name too long for the edge file: " + string(s.substr(0, 64)));
+    }
+    const auto length = static_cast<uint16_t>(s.length());
+    out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.write(s.data(), s.length());
+  }
+
+  void ReadString(istream& in, string& s) {
+    uint16_t length = 0;
+    in.read(reinterpret_cast<char*>(&length), sizeof(length));
+    s.resize(length);
+    in.read(s.data(), length);
+  }
+
+  // Reads one sorted run back in batches; all runs share one stream so the fan-in isn't limited by open handles
+  struct run_reader {
+    uint64_t position;
+    uint64_t remaining;
+    vector<reference_edge> batch;
+    size_t next = 0;
+
+    run_reader(uint64_t offset, uint64_t count) : position(offset), remaining(count) {}
+
+    const reference_edge& Current() const { return batch[next - 1]; }
+
+    bool Next(istream& in, size_t batchSize) {
+      if (next < batch.size()) {
+        next++;
+        return true;
+      }
+      if (remaining == 0) return false;
+      const auto n = static_cast<size_t>(min<uint64_t>(remaining, batchSize));
+      batch.resize(n);
+      in.clear();
+      in.seekg(position);
+      for (auto& e : batch) {
+        ReadString(in, e.targetNamespace);
+        ReadString(in, e.targetType);
+        ReadString(in, e.sourceName);
+        ReadString(in, e.sourceNamespace);
+      }
+      if (!in) {
+        throw std::runtime_error("edge file is truncated");
+      }
+      position = in.tellg();
+      remaining -= n;
+      next = 1;
+      return true;
+    }
+  };
+}
+
+reference_spill::reference_spill(filesystem::path edgeFile, size_t budgetBytes) : path(std::move(edgeFile)), budget(budgetBytes) {
+}
+
+reference_spill::~reference_spill() {
+  if (file.is_open()) {
+    file.close();
+  }
+  std::error_code ec;
+  filesystem::remove(path, ec); // ignore ec
+}
+
+void reference_spill::Add(string_view targetNamespace, string_view targetType, string_view sourceNamespace, string_view sourceName) {
+  buffer.push_back({ string(targetNamespace), string(targetType), string(sourceName), string(sourceNamespace) });
+  buffered += buffer.back().Footprint();
+  if (buffered >= budget) {
+    Flush();
+  }
+}
+
+void reference_spill::Flush() {
+  sort(buffer.begin(), buffer.end());
+  buffer.erase(unique(buffer.begin(), buffer.end()), buffer.end());
+  if (!file.is_open()) {
+    file.open(path, ios::binary | ios::trunc);
+    if (!file) {
+      throw std::runtime_error("couldn't create edge file " + path.u8string());
+    }
+  }
+  runs.push_back({ static_cast<uint64_t>(file.tellp()), buffer.size() });
+  for (const auto& e : buffer) {
+    WriteString(file, e.targetNamespace);
+    WriteString(file, e.targetType);
+    WriteString(file, e.sourceName);
+    WriteString(file, e.sourceNamespace);
+  }
+  buffer.clear();
+  buffer.shrink_to_fit();
+  buffered = 0;
+}
+
+void reference_spill::Merge(const target_handler& handler) {
+  // Edges arrive in sorted order; group them by target and drop duplicates
+  bool any = false;
+  reference_edge last;
+  vector<string> referrers;
+  auto emit = [&]() {
+    if (any) {
+      handler(last.targetNamespace, last.targetType, referrers);
+    }
+    referrers.clear();
+  };
+  auto accept = [&](const reference_edge& e) {
+    if (any && last == e) return;
+    if (!any || e.targetNamespace != last.targetNamespace || e.targetType != last.targetType) {
+      emit();
+    }
+    last = e;
+    any = true;
+    referrers.push_back(e.sourceName);
+  };
+
+  if (runs.empty()) {
+    sort(buffer.begin(), buffer.end());
+    for (const auto& e : buffer) {
+      accept(e);
+    }
+    emit();
+    buffer.clear();
+    buffered = 0;
+    return;
+  }
+
+  if (!buffer.empty()) {
+    Flush();
+  }
+  file.close();
+
+  // Split the budget between the runs; each run reads at least one edge at a time
+  constexpr size_t averageEdge = sizeof(reference_edge) + 64;
+  const size_t batchSize = max<size_t>(1, budget / (runs.size() * averageEdge));
+  ifstream in(path, ios::binary);
+  vector<run_reader> readers;
+  readers.reserve(runs.size());
+  for (const auto& r : runs) {
+    readers.emplace_back(r.offset, r.count);
+  }
+  auto greater = [&readers](size_t a, size_t b) { return readers[b].Current() < readers[a].Current(); };
+  priority_queue<size_t, vector<size_t>, decltype(greater)> heads(greater);
+  for (size_t i = 0; i < readers.size(); i++) {
+    if (readers[i].Next(in, batchSize)) {
+      heads.push(i);
+    }
+  }
+  while (!heads.empty()) {
+    const auto i = heads.top();
+    heads.pop();
+    accept(readers[i].Current());
+    if (readers[i].Next(in, batchSize)) {
+      heads.push(i);
+    }
+  }
+  emit();
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+/// One "type A is referenced by type B" edge.
+struct reference_edge
+{
+  std::string targetNamespace;
+  std::string targetType;
+  std::string sourceName;
+  std::string sourceNamespace;
+
+  bool operator<(const reference_edge& o) const {
+    return std::tie(targetNamespace, targetType, sourceName, sourceNamespace) < std::tie(o.targetNamespace, o.targetType, o.sourceName, o.sourceNamespace);
+  }
+  bool operator==(const reference_edge& o) const {
+    return targetNamespace == o.targetNamespace && targetType == o.targetType && sourceName == o.sourceName && sourceNamespace == o.sourceNamespace;
+  }
+  size_t Footprint() const {
+    return sizeof(reference_edge) + targetNamespace.length() + targetType.length() + sourceName.length() + sourceNamespace.length();
+  }
+};
+
+/// <summary>
+/// Back-reference store for /streaming. Edges are buffered until they reach the memory budget, then sorted
+/// and appended to the edge file as a run. Merge does a k-way merge over the runs, so only one edge per run
+/// and the referrers of a single type are in memory at a time. Nothing touches the disk if everything fits.
+/// </summary>
+struct reference_spill
+{
+  using target_handler = std::function<void(const std::string& ns, const std::string& type, const std::vector<std::string>& sortedReferrers)>;
+
+  reference_spill(std::filesystem::path edgeFile, size_t budgetBytes);
+  ~reference_spill();
+
+  void Add(std::string_view targetNamespace, std::string_view targetType, std::string_view sourceNamespace, std::string_view sourceName);
+
+  /// Calls handler once per referenced type, in (namespace, type) order, with the referrer names sorted and de-duplicated.
+  void Merge(const target_handler& handler);
+
+  size_t RunCount() const { return runs.size(); }
+
+private:
+  struct run {
+    uint64_t offset;
+    uint64_t count;
+  };
+
+  void Flush();
+
+  std::filesystem::path path;
+  size_t budget;
+  size_t buffered = 0;
+  std::vector<reference_edge> buffer;
+  std::ofstream file;
+  std::vector<run> runs;
+};
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <cctype>
+
+#include "NdJson.h"
+#include "SearchIndex.h"
+
+using namespace std;
+
+namespace {
+  bool IsLower(char c) { return islower(static_cast<unsigned char>(c)) != 0; }
+  bool IsUpper(char c) { return isupper(static_cast<unsigned char>(c)) != 0; }
+  bool IsWordChar(char c) { return isalnum(static_cast<unsigned char>(c)) != 0 || c == '_'; }
+
+  string Lower(string_view s) {
+    string lower(s);
+    transform(lower.begin(), lower.end(), lower.begin(), [](char c) { return static_cast<char>(tolower(static_cast<unsigned char>(c))); });
+    return lower;
+  }
+
+  constexpr string_view stopWords[] = {
+    "an", "and", "are", "as", "at", "be", "by", "can", "for", "from", "if", "in", "is", "it", "its", "of", "on", "or",
+    "that", "the", "this", "to", "use", "was", "when", "which", "will", "with",
+  };
+}
+
+vector<string> search_index::SplitName(string_view name) {
+  vector<string> words;
+  size_t start = 0;
+  auto cut = [&](size_t end) {
+    if (end > start) words.push_back(Lower(name.substr(start, end - start)));
+    start = end;
+  };
+  for (size_t i = 0; i < name.length(); i++) {
+    if (!isalnum(static_cast<unsigned char>(name[i]))) {
+      cut(i);
+      start = i + 1;
+    }
+    else if (i > start && IsUpper(name[i])) {
+      // a word starts at an upper-case letter after a lower-case one (myProperty),
+      // or at the last capital of an acronym that's followed by a lower-case letter (XMLHttp)
+      if (!IsUpper(name[i - 1]) || (i + 1 < name.length() && IsLower(name[i + 1]))) {
+        cut(i);
+      }
+    }
+  }
+  cut(name.length());
+  return words;
+}
+
+vector<string> search_index::SplitText(string_view text) {
+  vector<string> words;
+  size_t i = 0;
+  while (i < text.length()) {
+    while (i < text.length() && !IsWordChar(text[i])) i++;
+    const auto start = i;
+    while (i < text.length() && IsWordChar(text[i])) i++;
+    if (i - start < 2) continue;
+    auto word = Lower(text.substr(start, i - start));
+    if (find(begin(stopWords), end(stopWords), word) == end(stopWords)) {
+      words.push_back(std::move(word));
+    }
+  }
+  return words;
+}
+
+uint32_t search_index::AddDoc(string title, string link) {
+  const auto id = static_cast<uint32_t>(docs.size());
+  const auto [it, added] = docIds.emplace(make_pair(title, link), id);
+  if (added) {
+    docs.emplace_back(std::move(title), std::move(link));
+  }
+  return it->second;
+}
+
+void search_index::AddTerm(string term, uint32_t doc) {
+  auto& postings = terms[std::move(term)];
+  // docs mostly arrive in order; an overload shares the doc of the member before it
+  const auto at = lower_bound(postings.begin(), postings.end(), doc);
+  if (at == postings.end() || *at != doc) {
+    postings.insert(at, doc);
+  }
+}
+
+void search_index::Add(const model_record& record, string_view page) {
+  const string type(record.type);
+  string title = type;
+  string link(page.empty() ? record.type : page);
+  if (!IsType(record.kind)) {
+    title += "." + string(record.member);
+    if (record.kind != model_kind::EnumValue) {
+      // the anchor of the member's heading on the type's page; a member called Properties gets -1 since the
+      // section heading already took #properties
+      const auto anchor = Lower(record.member);
+      link += "#" + (anchor == "properties" ? anchor + "-1" : anchor);
+    }
+  }
+  const auto doc = AddDoc(std::move(title), std::move(link));
+
+  const auto name = IsType(record.kind) ? record.type : record.member;
+  AddTerm(Lower(name), doc);
+  for (auto& word : SplitName(name)) {
+    AddTerm(std::move(word), doc);
+  }
+  for (auto& word : SplitText(record.doc)) {
+    AddTerm(std::move(word), doc);
+  }
+}
+
+void search_index::Write(ostream& out) const {
+  string json = "{\"version\":1,\"docs\":[";
+  for (size_t i = 0; i < docs.size(); i++) {
+    if (i != 0) json += ',';
+    json += '[';
+    json_record::Escape(json, docs[i].first);
+    json += ',';
+    json_record::Escape(json, docs[i].second);
+    json += ']';
+  }
+  json += "],\"terms\":[";
+  bool first = true;
+  for (const auto& [term, postings] : terms) {
+    if (!first) json += ',';
+    first = false;
+    json_record::Escape(json, term);
+  }
+  json += "],\"postings\":[";
+  first = true;
+  for (const auto& [term, postings] : terms) {
+    if (!first) json += ',';
+    first = false;
+    json += '[';
+    uint32_t previous = 0;
+    for (size_t i = 0; i < postings.size(); i++) {
+      if (i != 0) json += ',';
+      json += to_string(postings[i] - previous);
+      previous = postings[i];
+    }
+    json += ']';
+  }
+  json += "]}\n";
+  out << json;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Model.h"
+
+/// <summary>
+/// Inverted index for client-side search (/searchIndex), built from the model records as the pages are rendered.
+/// Type and member names are indexed whole and split into camel-case words; doc strings contribute their words.
+/// It's written as one JSON object so a browser can load it directly:
+///   docs:     [title, link] per page or member anchor, e.g. ["Class1.MyProperty", "Class1#myproperty"]
+///   terms:    every term, sorted, so a prefix is a contiguous range that can be binary searched
+///   postings: per term, the docs it occurs in as ascending indices into docs, each stored as the difference from
+///             the previous one
+/// </summary>
+struct search_index
+{
+  /// page is the link to the type's page, when it isn't just the type name (/fanOut)
+  void Add(const model_record& record, std::string_view page = {});
+  void Write(std::ostream& out) const;
+
+  /// Lower-cased words of an identifier: "IXmlHttpRequest2" gives "i", "xml", "http", "request2".
+  static std::vector<std::string> SplitName(std::string_view name);
+  /// Lower-cased words of prose, without very short and very common words.
+  static std::vector<std::string> SplitText(std::string_view text);
+
+  size_t DocCount() const { return docs.size(); }
+  size_t TermCount() const { return terms.size(); }
+
+private:
+  uint32_t AddDoc(std::string title, std::string link);
+  void AddTerm(std::string term, uint32_t doc);
+
+  std::vector<std::pair<std::string, std::string>> docs;
+  std::map<std::pair<std::string, std::string>, uint32_t> docIds;
+  std::map<std::string, std::vector<uint32_t>> terms;
+};
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <sstream>
+
+#include "Compression.h"
+#include "Shard.h"
+
+using namespace std;
+
+namespace {
+  constexpr string_view header = "winmd2md-shard 1";
+
+  vector<string> SplitFields(const string& line) {
+    vector<string> fields;
+    size_t start = 0;
+    for (auto tab = line.find('\t'); tab != string::npos; tab = line.find('\t', start)) {
+      fields.push_back(line.substr(start, tab - start));
+      start = tab + 1;
+    }
+    fields.push_back(line.substr(start));
+    return fields;
+  }
+}
+
+shard_writer::shard_writer(string_view spec, string_view outputDirectory, string_view fingerprint) {
+  const auto slash = spec.find('/');
+  if (slash != string_view::npos) {
+    index = static_cast<uint32_t>(stoul(string(spec.substr(0, slash))));
+    count = static_cast<uint32_t>(stoul(string(spec.substr(slash + 1))));
+  }
+  if (count == 0 || index == 0 || index > count) {
+    throw invalid_argument("/shard expects i/n with i from 1 to n, e.g. /shard 3/8");
+  }
+  filesystem::create_directories(filesystem::u8path(outputDirectory));
+  file = FileName(outputDirectory, index, count);
+  out.open(file, ios::binary | ios::trunc);
+  out << header << '\t' << index << '\t' << count << '\t' << fingerprint << '\n';
+}
+
+filesystem::path shard_writer::FileName(string_view outputDirectory, uint32_t index, uint32_t count) {
+  return filesystem::u8path(outputDirectory) / ("shard-" + to_string(index) + "-of-" + to_string(count) + ".w2shard");
+}
+
+bool shard_writer::Owns(string_view ns, string_view type) const {
+  return Crc32(type, Crc32(".", Crc32(ns))) % count == index - 1;
+}
+
+void shard_writer::StartNamespace(string_view ns) {
+  out << "N\t" << ns << '\n';
+}
+
+void shard_writer::AddType(uint32_t seq, model_kind kind, string_view ns, string_view name, string_view xml) {
+  sequence[string(ns) + "." + string(name)] = seq;
+  out << "T\t" << seq << '\t' << static_cast<uint32_t>(kind) << '\t' << name << '\t' << xml.length() << '\n';
+  out.write(xml.data(), xml.length());
+}
+
+void shard_writer::AddReference(string_view ns, string_view type, string_view referrerNs, string_view referrer) {
+  out << "R\t" << ns << '\t' << type << '\t' << referrerNs << '\t' << referrer << '\n';
+}
+
+void shard_writer::AddImplementation(string_view iface, string_view implementerNs, string_view implementer) {
+  const auto seq = sequence.at(string(implementerNs) + "." + string(implementer));
+  out << "I\t" << iface << '\t' << seq << '\t' << implementerNs << '\t' << implementer << '\n';
+}
+
+void shard_writer::Close() {
+  out.close();
+  if (!out) {
+    throw runtime_error("Failed to write " + file.u8string());
+  }
+}
+
+void shard_data::Read(string_view outputDirectory, uint32_t count) {
+  for (uint32_t index = 1; index <= count; index++) {
+    const auto path = shard_writer::FileName(outputDirectory, index, count);
+    ifstream in(path, ios::binary);
+    if (!in) {
+      throw runtime_error("Missing shard " + to_string(index) + " of " + to_string(count) + ": " + path.u8string());
+    }
+    files.push_back(path);
+    auto corrupt = [&path]() { return runtime_error("Corrupt shard file " + path.u8string()); };
+
+    string line;
+    getline(in, line);
+    const auto head = SplitFields(line);
+    if (head.size() != 4 || head[0] != header || head[1] != to_string(index) || head[2] != to_string(count)) throw corrupt();
+    if (index == 1) {
+      fingerprint = head[3];
+    }
+    else if (head[3] != fingerprint) {
+      throw runtime_error("The shards were rendered with different options: " + path.u8string());
+    }
+
+    uint32_t ns = 0;
+    bool first = true;
+    while (getline(in, line)) {
+      const auto fields = SplitFields(line);
+      if (fields[0] == "N" && fields.size() == 2) {
+        ns = first ? 0 : ns + 1;
+        first = false;
+        if (index == 1) {
+          namespaces.push_back(fields[1]);
+        }
+        else if (ns >= namespaces.size() || namespaces[ns] != fields[1]) {
+          throw runtime_error("The shards were rendered from different WinMDs: " + path.u8string());
+        }
+      }
+      else if (fields[0] == "T" && fields.size() == 5 && !first) {
+        type t{ static_cast<uint32_t>(stoul(fields[1])), ns, static_cast<model_kind>(stoul(fields[2])), fields[3], string(stoul(fields[4]), '\0') };
+        in.read(t.xml.data(), t.xml.length());
+        if (!in) throw corrupt();
+        types.push_back(std::move(t));
+      }
+      else if (fields[0] == "R" && fields.size() == 5) {
+        references.push_back({ fields[1], fields[2], fields[3], fields[4] });
+      }
+      else if (fields[0] == "I" && fields.size() == 5) {
+        implementations.push_back({ fields[1], static_cast<uint32_t>(stoul(fields[2])), fields[3], fields[4] });
+      }
+      else {
+        throw corrupt();
+      }
+    }
+    if (index > 1 && (first ? 0 : ns + 1) != namespaces.size()) {
+      throw runtime_error("The shards were rendered from different WinMDs: " + path.u8string());
+    }
+  }
+
+  sort(types.begin(), types.end(), [](const type& a, const type& b) { return a.seq < b.seq; });
+  for (size_t i = 0; i < types.size(); i++) {
+    if (types[i].seq != i) {
+      throw runtime_error("The shard files don't cover every type; were they all rendered from the same WinMD?");
+    }
+  }
+  stable_sort(implementations.begin(), implementations.end(), [](const implementation& a, const implementation& b) { return a.seq < b.seq; });
+}
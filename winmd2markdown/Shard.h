@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Model.h"
+
+/// <summary>
+/// One of several processes rendering the same WinMD (/shard i/n). Every shard walks the types in the same order as a
+/// single-process run and numbers them, but only renders the ones whose Namespace.Type hashes to it. What the other
+/// shards need to finish the docs goes into a partial file in the output directory, which /mergeShards combines:
+///   N namespace                                     every namespace that gets pages, in order
+///   T seq kind name length, then length bytes       a type this shard rendered, and its intellisense members
+///   R ns type referrerNs referrer                   a reference from one of this shard's types
+///   I interface seq ns name                         one of this shard's types implementing an interface
+/// Fields are tab-separated. The first line names the shard and the options that shape the pages.
+/// </summary>
+struct shard_writer
+{
+  /// Where an interface's "Implemented by" list goes; only the merge knows every implementer.
+  static constexpr std::string_view implementedByMarker = "\x1e" "implemented by\n";
+
+  /// spec is "i/n", with i from 1 to n
+  shard_writer(std::string_view spec, std::string_view outputDirectory, std::string_view fingerprint);
+
+  static std::filesystem::path FileName(std::string_view outputDirectory, uint32_t index, uint32_t count);
+
+  bool Owns(std::string_view ns, std::string_view type) const;
+  void StartNamespace(std::string_view ns);
+  /// Numbers the next type in rendering order, whichever shard renders it.
+  uint32_t NextType() { return nextType++; }
+  void AddType(uint32_t seq, model_kind kind, std::string_view ns, std::string_view name, std::string_view xml);
+  void AddReference(std::string_view ns, std::string_view type, std::string_view referrerNs, std::string_view referrer);
+  /// implementer has to be one of this shard's types
+  void AddImplementation(std::string_view iface, std::string_view implementerNs, std::string_view implementer);
+  void Close();
+
+  uint32_t Index() const { return index; }
+  uint32_t Count() const { return count; }
+  size_t Rendered() const { return sequence.size(); }
+
+private:
+  uint32_t index = 0;
+  uint32_t count = 0;
+  uint32_t nextType = 0;
+  std::map<std::string, uint32_t> sequence;
+  std::filesystem::path file;
+  std::ofstream out;
+};
+
+/// <summary>
+/// The partial files of all the shards of a run, read back for /mergeShards.
+/// </summary>
+struct shard_data
+{
+  struct type {
+    uint32_t seq;
+    uint32_t ns;
+    model_kind kind;
+    std::string name;
+    std::string xml;
+  };
+  struct reference {
+    std::string ns;
+    std::string type;
+    std::string referrerNs;
+    std::string referrer;
+  };
+  struct implementation {
+    std::string iface;
+    uint32_t seq;
+    std::string ns;
+    std::string name;
+  };
+
+  /// Reads every shard's file; throws if one is missing, or they don't belong to the same run.
+  void Read(std::string_view outputDirectory, uint32_t count);
+
+  std::string fingerprint;
+  std::vector<std::string> namespaces;
+  /// In rendering order
+  std::vector<type> types;
+  std::vector<reference> references;
+  /// In the order the implementers are rendered
+  std::vector<implementation> implementations;
+  std::vector<std::filesystem::path> files;
+};
@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+
+#include "Snapshot.h"
+
+using namespace std;
+using namespace snapshot_format;
+
+namespace {
+  uint32_t Count(size_t n) {
+    if (n > UINT32_MAX) {
+      throw std::length_error("The model is too large for a snapshot");
+    }
+    return static_cast<uint32_t>(n);
+  }
+
+  uint32_t Flags(const model_record& record) {
+    uint32_t flags = 0;
+    if (record.experimental) flags |= flag::experimental;
+    if (record.isStatic) flags |= flag::isStatic;
+    if (record.readonly) flags |= flag::readonly;
+    return flags;
+  }
+}
+
+str snapshot_writer::Store(string_view s) {
+  const str ref{ Count(strings.length()), Count(s.length()) };
+  strings += s;
+  Count(strings.length());
+  return ref;
+}
+
+str snapshot_writer::Intern(string_view s) {
+  const auto it = interned.find(string(s));
+  if (it != interned.end()) {
+    return it->second;
+  }
+  const auto ref = Store(s);
+  interned.emplace(s, ref);
+  return ref;
+}
+
+range snapshot_writer::Names(const vector<string>& list) {
+  const range r{ Count(names.size()), Count(list.size()) };
+  for (const auto& n : list) {
+    names.push_back(Intern(n));
+  }
+  return r;
+}
+
+void snapshot_writer::StartNamespace(string_view ns) {
+  const auto first = Count(types.size());
+  const auto firstXml = Count(xml.size());
+  namespaces.push_back({ Intern(ns), { first, 0 }, { firstXml, 0 }, { 0, 0 } });
+}
+
+void snapshot_writer::Add(const model_record& record) {
+  if (namespaces.empty()) {
+    throw std::logic_error("snapshot records have to be added inside a namespace");
+  }
+  if (IsType(record.kind)) {
+    type_entry t{};
+    t.ns = Intern(record.ns);
+    t.name = Intern(record.type);
+    t.kind = record.kind;
+    t.flags = Flags(record);
+    t.extends = Intern(record.valueType);
+    t.implements = Names(record.implements);
+    t.deprecated = Store(record.deprecated);
+    t.defaultValue = Store(record.defaultValue);
+    t.doc = Store(record.doc);
+    t.members = { Count(members.size()), 0 };
+    types.push_back(t);
+    namespaces.back().types.count++;
+    return;
+  }
+
+  if (types.empty()) {
+    throw std::logic_error("a member was added before its type");
+  }
+  member_entry m{};
+  m.value = record.value;
+  m.typeIndex = Count(types.size() - 1);
+  m.kind = record.kind;
+  m.flags = Flags(record);
+  m.name = Intern(record.member);
+  m.valueType = Intern(record.valueType);
+  m.signature = Store(record.signature);
+  m.deprecated = Store(record.deprecated);
+  m.defaultValue = Store(record.defaultValue);
+  m.doc = Store(record.doc);
+  m.parameters = { Count(parameters.size()), Count(record.parameters.size()) };
+  for (const auto& p : record.parameters) {
+    parameters.push_back({ Intern(p.name), Intern(p.type), p.out ? uint32_t{ flag::out } : 0u });
+  }
+  members.push_back(m);
+  types.back().members.count++;
+}
+
+void snapshot_writer::SetPage(string_view markdown) {
+  if (!types.empty()) {
+    types.back().page = Store(markdown);
+  }
+}
+
+void snapshot_writer::AddXmlMember(char memberType, string_view name, string_view summary) {
+  if (namespaces.empty()) return;
+  xml.push_back({ static_cast<uint32_t>(memberType), Intern(name), Store(summary) });
+  namespaces.back().xml.count++;
+}
+
+void snapshot_writer::AddReferrers(string_view ns, string_view type, const vector<string>& sortedReferrers) {
+  referenced.emplace_back(string(ns), referenced_entry{ Intern(type), Names(sortedReferrers) });
+}
+
+void snapshot_writer::Close() {
+  // group the back-references by namespace, in namespace order
+  map<string_view, size_t> namespaceIndex;
+  for (size_t i = 0; i < namespaces.size(); i++) {
+    namespaceIndex.emplace(string_view(strings).substr(namespaces[i].name.offset, namespaces[i].name.length), i);
+  }
+  vector<vector<referenced_entry>> byNamespace(namespaces.size());
+  for (const auto& [ns, entry] : referenced) {
+    const auto it = namespaceIndex.find(ns);
+    if (it != namespaceIndex.end()) {
+      byNamespace[it->second].push_back(entry);
+    }
+  }
+  vector<referenced_entry> referencedTable;
+  for (size_t i = 0; i < namespaces.size(); i++) {
+    namespaces[i].referenced = { Count(referencedTable.size()), Count(byNamespace[i].size()) };
+    referencedTable.insert(referencedTable.end(), byNamespace[i].begin(), byNamespace[i].end());
+  }
+
+  vector<uint32_t> typesByName(types.size());
+  iota(typesByName.begin(), typesByName.end(), 0);
+  auto text = [this](str s) { return string_view(strings).substr(s.offset, s.length); };
+  sort(typesByName.begin(), typesByName.end(), [&](uint32_t a, uint32_t b) {
+    return make_pair(text(types[a].ns), text(types[a].name)) < make_pair(text(types[b].ns), text(types[b].name));
+  });
+
+  header h{};
+  copy(begin(magic), end(magic), h.magic);
+  h.version = version;
+  uint64_t position = sizeof(header);
+  auto place = [&position](table_ref& t, size_t count, size_t entrySize) {
+    position = (position + 7) & ~uint64_t{ 7 };
+    t = { position, Count(count), Count(entrySize) };
+    position += count * entrySize;
+  };
+  place(h.namespaces, namespaces.size(), sizeof(namespace_entry));
+  place(h.types, types.size(), sizeof(type_entry));
+  place(h.typesByName, typesByName.size(), sizeof(uint32_t));
+  place(h.members, members.size(), sizeof(member_entry));
+  place(h.parameters, parameters.size(), sizeof(parameter_entry));
+  place(h.xml, xml.size(), sizeof(xml_entry));
+  place(h.referenced, referencedTable.size(), sizeof(referenced_entry));
+  place(h.names, names.size(), sizeof(str));
+  h.stringsOffset = position;
+  h.stringsSize = strings.size();
+
+  if (path.has_parent_path()) {
+    filesystem::create_directories(path.parent_path());
+  }
+  ofstream out(path, ios::binary | ios::trunc);
+  uint64_t written = 0;
+  auto write = [&](const void* p, uint64_t offset, size_t bytes) {
+    static const char padding[8]{};
+    out.write(padding, static_cast<streamsize>(offset - written));
+    out.write(static_cast<const char*>(p), bytes);
+    written = offset + bytes;
+  };
+  write(&h, 0, sizeof(h));
+  write(namespaces.data(), h.namespaces.offset, namespaces.size() * sizeof(namespace_entry));
+  write(types.data(), h.types.offset, types.size() * sizeof(type_entry));
+  write(typesByName.data(), h.typesByName.offset, typesByName.size() * sizeof(uint32_t));
+  write(members.data(), h.members.offset, members.size() * sizeof(member_entry));
+  write(parameters.data(), h.parameters.offset, parameters.size() * sizeof(parameter_entry));
+  write(xml.data(), h.xml.offset, xml.size() * sizeof(xml_entry));
+  write(referencedTable.data(), h.referenced.offset, referencedTable.size() * sizeof(referenced_entry));
+  write(names.data(), h.names.offset, names.size() * sizeof(str));
+  write(strings.data(), h.stringsOffset, strings.size());
+  out.close();
+  if (out.fail()) {
+    throw std::runtime_error("Failed to write snapshot " + path.u8string());
+  }
+}
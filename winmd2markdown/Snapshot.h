@@ -0,0 +1,46 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Model.h"
+#include "SnapshotReader.h"
+
+/// <summary>
+/// Collects the resolved model while the pages are rendered and writes it as a snapshot (/outputSnapshot) when it's
+/// closed: the model records, each type's rendered page, the intellisense entries and the back-references. The
+/// layout is in SnapshotReader.h.
+/// </summary>
+struct snapshot_writer
+{
+  snapshot_writer(const std::filesystem::path& snapshotFile) : path(snapshotFile) {}
+
+  void StartNamespace(std::string_view ns);
+  /// Adds a type, or a member of the type added last.
+  void Add(const model_record& record);
+  /// Sets the rendered page of the type added last.
+  void SetPage(std::string_view markdown);
+  void AddXmlMember(char memberType, std::string_view name, std::string_view summary);
+  void AddReferrers(std::string_view ns, std::string_view type, const std::vector<std::string>& sortedReferrers);
+  void Close();
+
+private:
+  snapshot_format::str Store(std::string_view s);
+  /// Like Store, but names and types are stored once however often they come up
+  snapshot_format::str Intern(std::string_view s);
+  snapshot_format::range Names(const std::vector<std::string>& names);
+
+  std::filesystem::path path;
+  std::string strings;
+  std::unordered_map<std::string, snapshot_format::str> interned;
+  std::vector<snapshot_format::namespace_entry> namespaces;
+  std::vector<snapshot_format::type_entry> types;
+  std::vector<snapshot_format::member_entry> members;
+  std::vector<snapshot_format::parameter_entry> parameters;
+  std::vector<snapshot_format::xml_entry> xml;
+  std::vector<snapshot_format::str> names;
+  // back-references only arrive at the very end in streaming mode, so they're grouped by namespace on Close
+  std::vector<std::pair<std::string, snapshot_format::referenced_entry>> referenced;
+};
@@ -0,0 +1,186 @@
+#pragma once
+// Reader for the documentation model snapshots written by winmd2markdown /outputSnapshot. This header only depends on
+// the standard library and Model.h, so other tools can include it directly: map the file (or read it into memory)
+// and query it in place through snapshot_view, without parsing or copying anything.
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+#include "Model.h"
+
+/// <summary>
+/// Snapshot layout. Everything is little-endian, and every table starts on an 8 byte boundary:
+///   header:  magic "W2MDSNAP", u32 version, u32 reserved, then an offset and size for the string data followed by
+///            one table_ref per table, in the order of the header struct below
+///   strings: UTF-8 text that the tables point into with (offset, length) pairs; not NUL terminated
+///   tables:  arrays of the fixed-size entries below. A range is a (first, count) slice of another table
+/// Types are grouped by namespace in page order, and a type's members are contiguous in page order, so readers
+/// can walk the model the way the pages present it. typesByName holds type indices sorted by namespace, then name.
+/// </summary>
+namespace snapshot_format {
+  constexpr char magic[8] = { 'W', '2', 'M', 'D', 'S', 'N', 'A', 'P' };
+  constexpr uint32_t version = 1;
+
+  struct str { uint32_t offset; uint32_t length; };
+  struct range { uint32_t first; uint32_t count; };
+  struct table_ref { uint64_t offset; uint32_t count; uint32_t entrySize; };
+
+  enum flag : uint32_t
+  {
+    experimental = 1,
+    isStatic = 2,
+    readonly = 4,
+    out = 8,
+  };
+
+  struct namespace_entry {
+    str name;
+    range types;
+    /// Entries of the namespace's intellisense file
+    range xml;
+    /// Types in this namespace that other types refer to
+    range referenced;
+  };
+
+  struct type_entry {
+    str ns;
+    str name;
+    model_kind kind;
+    uint32_t flags;
+    str extends;
+    /// Slice of names
+    range implements;
+    str deprecated;
+    str defaultValue;
+    str doc;
+    /// The rendered markdown, from after the "Kind:" line up to where "Referenced by" gets appended
+    str page;
+    range members;
+  };
+
+  struct member_entry {
+    int64_t value;
+    uint32_t typeIndex;
+    model_kind kind;
+    uint32_t flags;
+    str name;
+    str valueType;
+    str signature;
+    str deprecated;
+    str defaultValue;
+    str doc;
+    range parameters;
+    uint32_t reserved;
+  };
+
+  struct parameter_entry {
+    str name;
+    str type;
+    uint32_t flags;
+  };
+
+  struct xml_entry {
+    /// 'T', 'P', 'M', 'F' or 'E', as in the member's documentation ID
+    uint32_t memberType;
+    /// Type or Type.Member, relative to the namespace
+    str name;
+    str summary;
+  };
+
+  struct referenced_entry {
+    str type;
+    /// Slice of names, sorted
+    range referrers;
+  };
+
+  struct header {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+    table_ref namespaces;
+    table_ref types;
+    table_ref typesByName;
+    table_ref members;
+    table_ref parameters;
+    table_ref xml;
+    table_ref referenced;
+    table_ref names;
+  };
+
+  static_assert(sizeof(member_entry) % 8 == 0 && sizeof(header) % 8 == 0, "entries have to keep the tables aligned");
+}
+
+/// <summary>
+/// Read-only view of a snapshot in memory. The header and table bounds are checked up front and string references
+/// when they're resolved; nothing is copied, so the memory has to outlive the view.
+/// </summary>
+class snapshot_view
+{
+public:
+  template<typename T>
+  struct table {
+    const T* entries = nullptr;
+    uint32_t count = 0;
+    const T* begin() const { return entries; }
+    const T* end() const { return entries + count; }
+    uint32_t size() const { return count; }
+    const T& operator[](uint32_t i) const { return entries[i]; }
+    table slice(snapshot_format::range r) const {
+      if (r.first > count || r.count > count - r.first) throw std::out_of_range("snapshot range is out of bounds");
+      return { entries + r.first, r.count };
+    }
+  };
+
+  snapshot_view(const void* data, size_t size) : base(static_cast<const char*>(data)), size(size) {
+    using namespace snapshot_format;
+    if (size < sizeof(header)) throw std::runtime_error("not a snapshot");
+    std::memcpy(&h, base, sizeof(header));
+    if (std::memcmp(h.magic, magic, sizeof(magic)) != 0) throw std::runtime_error("not a snapshot");
+    if (h.version != version) throw std::runtime_error("the snapshot was written by a different version");
+    if (h.stringsOffset > size || h.stringsSize > size - h.stringsOffset) throw std::runtime_error("the snapshot is truncated");
+    strings = std::string_view(base + h.stringsOffset, static_cast<size_t>(h.stringsSize));
+  }
+
+  table<snapshot_format::namespace_entry> Namespaces() const { return Table<snapshot_format::namespace_entry>(h.namespaces); }
+  table<snapshot_format::type_entry> Types() const { return Table<snapshot_format::type_entry>(h.types); }
+  table<uint32_t> TypesByName() const { return Table<uint32_t>(h.typesByName); }
+  table<snapshot_format::member_entry> Members() const { return Table<snapshot_format::member_entry>(h.members); }
+  table<snapshot_format::parameter_entry> Parameters() const { return Table<snapshot_format::parameter_entry>(h.parameters); }
+  table<snapshot_format::xml_entry> Xml() const { return Table<snapshot_format::xml_entry>(h.xml); }
+  table<snapshot_format::referenced_entry> Referenced() const { return Table<snapshot_format::referenced_entry>(h.referenced); }
+  table<snapshot_format::str> Names() const { return Table<snapshot_format::str>(h.names); }
+
+  std::string_view operator[](snapshot_format::str s) const {
+    if (s.offset > strings.size() || s.length > strings.size() - s.offset) throw std::out_of_range("snapshot string is out of bounds");
+    return strings.substr(s.offset, s.length);
+  }
+
+  /// Returns the type with this namespace and name, or nullptr.
+  const snapshot_format::type_entry* FindType(std::string_view ns, std::string_view name) const {
+    const auto types = Types();
+    const auto byName = TypesByName();
+    const auto it = std::lower_bound(byName.begin(), byName.end(), std::make_pair(ns, name), [&](uint32_t i, const auto& key) {
+      return std::make_pair((*this)[types[i].ns], (*this)[types[i].name]) < key;
+    });
+    if (it == byName.end() || (*this)[types[*it].ns] != ns || (*this)[types[*it].name] != name) return nullptr;
+    return &types[*it];
+  }
+
+private:
+  template<typename T>
+  table<T> Table(const snapshot_format::table_ref& t) const {
+    if (t.entrySize != sizeof(T) || t.offset > size || t.count > (size - t.offset) / sizeof(T)) {
+      throw std::runtime_error("the snapshot's tables are corrupt");
+    }
+    return { reinterpret_cast<const T*>(base + t.offset), t.count };
+  }
+
+  const char* base;
+  size_t size;
+  snapshot_format::header h{};
+  std::string_view strings;
+};
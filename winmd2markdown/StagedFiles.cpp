@@ -0,0 +1,98 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <fcntl.h>
+#include <io.h>
+
+#include "StagedFiles.h"
+
+using namespace std;
+
+shared_ptr<ostream> staged_files::Open(const filesystem::path& path, bool append) {
+  auto& file = staged[path];
+  if (!file || !append) {
+    file = make_shared<ostringstream>();
+    if (append) {
+      ifstream existing(path, ios::binary);
+      if (existing) {
+        *file << existing.rdbuf();
+      }
+    }
+  }
+  return file;
+}
+
+bool staged_files::SameContents(const filesystem::path& path, string_view contents) {
+  error_code ec;
+  const auto size = filesystem::file_size(path, ec);
+  if (ec || size != contents.length()) return false;
+  ifstream existing(path, ios::binary);
+  char buffer[64 * 1024];
+  size_t at = 0;
+  while (at < contents.length()) {
+    existing.read(buffer, sizeof(buffer));
+    const auto n = static_cast<size_t>(existing.gcount());
+    if (n == 0 || n > contents.length() - at || memcmp(buffer, contents.data() + at, n) != 0) return false;
+    at += n;
+  }
+  return true;
+}
+
+void staged_files::Commit() {
+  // the map is sorted by path, so each directory's files are next to each other
+  struct pending { filesystem::path path; filesystem::path temp; };
+  vector<pending> batch;
+  auto discardBatch = [&]() {
+    error_code ec;
+    for (auto& p : batch) {
+      filesystem::remove(p.temp, ec);
+    }
+    batch.clear();
+  };
+  auto finishBatch = [&]() {
+    // the temporary files are closed by now, so the system may already be writing them back; reopen them one at a
+    // time to wait for that, since the CRT can only sync one file per call
+    for (auto& p : batch) {
+      const int fd = _wopen(p.temp.c_str(), _O_RDWR | _O_BINARY);
+      const bool synced = fd != -1 && _commit(fd) == 0;
+      if (fd != -1) _close(fd);
+      if (!synced) {
+        const auto failed = p.path.u8string();
+        discardBatch();
+        throw runtime_error("Failed to write " + failed);
+      }
+    }
+    for (auto& p : batch) {
+      filesystem::rename(p.temp, p.path);
+      written++;
+    }
+    batch.clear();
+  };
+
+  for (const auto& [path, stream] : staged) {
+    const auto contents = stream->str();
+    if (SameContents(path, contents)) {
+      unchanged++;
+      continue;
+    }
+    if (!batch.empty() && (batch.back().path.parent_path() != path.parent_path() || batch.size() == maxBatch)) {
+      finishBatch();
+    }
+    auto temp = path;
+    temp += ".tmp";
+    FILE* file = nullptr;
+    if (_wfopen_s(&file, temp.c_str(), L"wb") != 0 || !file) {
+      discardBatch();
+      throw runtime_error("Failed to create file " + temp.u8string());
+    }
+    batch.push_back({ path, temp });
+    const bool complete = fwrite(contents.data(), 1, contents.length(), file) == contents.length();
+    if (fclose(file) != 0 || !complete) {
+      discardBatch();
+      throw runtime_error("Failed to write " + path.u8string());
+    }
+  }
+  finishBatch();
+  staged.clear();
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string_view>
+
+/// <summary>
+/// Holds output files in memory until they're complete, then writes only the ones that changed (/atomicWrites).
+/// A file whose size and contents match what's already on disk is left alone, so its timestamp doesn't trigger
+/// rebuilds downstream. Changed files are written to a temporary file in the same directory, synced, and renamed
+/// over the old one, so a reader never sees half a page. Files are handled in batches of up to maxBatch from one
+/// directory: every temporary file of the batch is written and closed before the first one is synced, so the syncs
+/// overlap with the system writing the rest back. Each file still takes its own sync, and only one is open at a time.
+/// </summary>
+struct staged_files
+{
+  /// The stream for path. Opening a staged file again appends to it; appending to a file that isn't staged
+  /// starts from its current contents.
+  std::shared_ptr<std::ostream> Open(const std::filesystem::path& path, bool append);
+  /// Writes every staged file that changed and forgets them all.
+  void Commit();
+
+  size_t Written() const { return written; }
+  size_t Unchanged() const { return unchanged; }
+
+  static bool SameContents(const std::filesystem::path& path, std::string_view contents);
+
+  static constexpr size_t maxBatch = 256;
+
+private:
+  std::map<std::filesystem::path, std::shared_ptr<std::ostringstream>> staged;
+  size_t written = 0;
+  size_t unchanged = 0;
+};
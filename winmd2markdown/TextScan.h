@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define WINMD2MD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WINMD2MD_SSE2 1
+#endif
+
+/// <summary>
+/// Helpers to skip over runs of plain text quickly. Doc strings are mostly prose with sparse markers (@, `, <),
+/// so the scanners compare 16 (SSE2) or 32 (AVX2) bytes at a time and only fall back to a byte loop for the tail.
+/// The instruction set is picked at compile time; builds without SSE2 use the scalar loops.
+/// </summary>
+namespace text_scan {
+  inline uint32_t CountTrailingZeros(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+  }
+
+  constexpr bool IsIdentifierChar(char x) {
+    return (x >= 'a' && x <= 'z') || (x >= 'A' && x <= 'Z') || (x >= '0' && x <= '9') || x == '_' || x == '.';
+  }
+
+#if defined(WINMD2MD_AVX2)
+  using vec = __m256i;
+  constexpr size_t width = 32;
+  constexpr uint32_t allLanes = 0xffffffff;
+  inline vec Load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+  inline vec Splat(char c) { return _mm256_set1_epi8(c); }
+  inline vec Equal(vec a, vec b) { return _mm256_cmpeq_epi8(a, b); }
+  inline vec Or(vec a, vec b) { return _mm256_or_si256(a, b); }
+  inline vec Add(vec a, vec b) { return _mm256_add_epi8(a, b); }
+  inline vec Less(vec a, vec b) { return _mm256_cmpgt_epi8(b, a); }
+  inline uint32_t Mask(vec v) { return static_cast<uint32_t>(_mm256_movemask_epi8(v)); }
+#elif defined(WINMD2MD_SSE2)
+  using vec = __m128i;
+  constexpr size_t width = 16;
+  constexpr uint32_t allLanes = 0xffff;
+  inline vec Load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+  inline vec Splat(char c) { return _mm_set1_epi8(c); }
+  inline vec Equal(vec a, vec b) { return _mm_cmpeq_epi8(a, b); }
+  inline vec Or(vec a, vec b) { return _mm_or_si128(a, b); }
+  inline vec Add(vec a, vec b) { return _mm_add_epi8(a, b); }
+  inline vec Less(vec a, vec b) { return _mm_cmplt_epi8(a, b); }
+  inline uint32_t Mask(vec v) { return static_cast<uint32_t>(_mm_movemask_epi8(v)); }
+#endif
+
+#if defined(WINMD2MD_AVX2) || defined(WINMD2MD_SSE2)
+  // Lanes whose byte is in [lo, hi]: shift the range down to start at -128 and do a single signed compare
+  inline vec InRange(vec v, char lo, char hi) {
+    const auto shifted = Add(v, Splat(static_cast<char>(0x80 - lo)));
+    return Less(shifted, Splat(static_cast<char>(0x80 + (hi - lo + 1))));
+  }
+
+  inline vec IdentifierLanes(vec v) {
+    const auto lower = Or(v, Splat(0x20)); // folds A-Z onto a-z
+    return Or(Or(InRange(lower, 'a', 'z'), InRange(v, '0', '9')), Or(Equal(v, Splat('_')), Equal(v, Splat('.'))));
+  }
+#endif
+}
+
+/// Returns the position of the first a or b at or after pos, or text.length() if there is none.
+inline size_t FindFirstOf(std::string_view text, size_t pos, char a, char b) {
+  const char* const data = text.data();
+  const size_t length = text.length();
+#if defined(WINMD2MD_AVX2) || defined(WINMD2MD_SSE2)
+  using namespace text_scan;
+  const auto va = Splat(a);
+  const auto vb = Splat(b);
+  for (; pos + width <= length; pos += width) {
+    const auto chunk = Load(data + pos);
+    const auto mask = Mask(Or(Equal(chunk, va), Equal(chunk, vb)));
+    if (mask != 0) {
+      return pos + CountTrailingZeros(mask);
+    }
+  }
+#endif
+  for (; pos < length; pos++) {
+    if (data[pos] == a || data[pos] == b) {
+      return pos;
+    }
+  }
+  return length;
+}
+
+/// Returns the position of the first character at or after pos that can't be part of an @reference
+/// (letters, digits, _ and .), or text.length() if the identifier runs to the end.
+inline size_t SkipIdentifierChars(std::string_view text, size_t pos) {
+  const char* const data = text.data();
+  const size_t length = text.length();
+#if defined(WINMD2MD_AVX2) || defined(WINMD2MD_SSE2)
+  using namespace text_scan;
+  for (; pos + width <= length; pos += width) {
+    const auto mask = ~Mask(IdentifierLanes(Load(data + pos))) & allLanes;
+    if (mask != 0) {
+      return pos + CountTrailingZeros(mask);
+    }
+  }
+#endif
+  for (; pos < length; pos++) {
+    if (!text_scan::IsIdentifierChar(data[pos])) {
+      return pos;
+    }
+  }
+  return length;
+}
@@ -0,0 +1,61 @@
+#include "TypeFilter.h"
+
+using namespace std;
+
+type_filter::type_filter(string_view namespaces, string_view excludedNamespaces, string_view types, string_view excludedTypes) :
+  namespaces(Split(namespaces)), excludedNamespaces(Split(excludedNamespaces)), types(Split(types)), excludedTypes(Split(excludedTypes)) {
+}
+
+vector<string> type_filter::Split(string_view patterns) {
+  vector<string> split;
+  while (!patterns.empty()) {
+    const auto end = patterns.find(';');
+    const auto pattern = patterns.substr(0, end);
+    if (!pattern.empty()) {
+      split.emplace_back(pattern);
+    }
+    if (end == string_view::npos) break;
+    patterns.remove_prefix(end + 1);
+  }
+  return split;
+}
+
+bool type_filter::Glob(string_view pattern, string_view text) {
+  // the usual backtracking match: on a mismatch, let the last * swallow one more character
+  size_t p = 0, t = 0;
+  size_t star = string_view::npos, starText = 0;
+  while (t < text.length()) {
+    if (p < pattern.length() && (pattern[p] == '?' || pattern[p] == text[t])) {
+      p++;
+      t++;
+    }
+    else if (p < pattern.length() && pattern[p] == '*') {
+      star = p++;
+      starText = t;
+    }
+    else if (star != string_view::npos) {
+      p = star + 1;
+      t = ++starText;
+    }
+    else {
+      return false;
+    }
+  }
+  while (p < pattern.length() && pattern[p] == '*') p++;
+  return p == pattern.length();
+}
+
+bool type_filter::Any(const vector<string>& patterns, string_view ns, string_view type) {
+  const auto qualified = string(ns) + "." + string(type);
+  for (const auto& pattern : patterns) {
+    if (type.empty() ? Glob(pattern, ns) : Glob(pattern, pattern.find('.') == string::npos ? type : qualified)) return true;
+  }
+  return false;
+}
+
+bool type_filter::Matches(string_view ns, string_view type) const {
+  if (!namespaces.empty() && !Any(namespaces, ns, {})) return false;
+  if (Any(excludedNamespaces, ns, {})) return false;
+  if (!types.empty() && !Any(types, ns, type)) return false;
+  return !Any(excludedTypes, ns, type);
+}
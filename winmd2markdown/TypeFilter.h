@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// <summary>
+/// Which types get their pages written (/namespace, /excludeNamespace, /type, /excludeType). Each takes a list of
+/// glob patterns separated by ';', where * matches any run of characters and ? any one character. A type is selected
+/// when its namespace matches an included pattern (or none were given) and no excluded one, and likewise for the
+/// type. Type patterns with a '.' are matched against Namespace.Type, the others against the type name alone.
+/// </summary>
+struct type_filter
+{
+  type_filter() = default;
+  type_filter(std::string_view namespaces, std::string_view excludedNamespaces, std::string_view types, std::string_view excludedTypes);
+
+  bool Active() const { return !namespaces.empty() || !excludedNamespaces.empty() || !types.empty() || !excludedTypes.empty(); }
+  bool Matches(std::string_view ns, std::string_view type) const;
+
+  static bool Glob(std::string_view pattern, std::string_view text);
+
+private:
+  static std::vector<std::string> Split(std::string_view patterns);
+  static bool Any(const std::vector<std::string>& patterns, std::string_view ns, std::string_view type);
+
+  std::vector<std::string> namespaces;
+  std::vector<std::string> excludedNamespaces;
+  std::vector<std::string> types;
+  std::vector<std::string> excludedTypes;
+};
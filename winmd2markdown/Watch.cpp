@@ -0,0 +1,52 @@
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+#include <stdexcept>
+#include <string>
+
+#include "Watch.h"
+
+using namespace std;
+
+file_watcher::file_watcher(filesystem::path watchedFile) : file(std::move(watchedFile)) {
+  handle = FindFirstChangeNotificationW(file.parent_path().c_str(), FALSE,
+    FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_FILE_NAME);
+  if (handle == INVALID_HANDLE_VALUE) {
+    throw std::runtime_error("Couldn't watch " + file.parent_path().u8string());
+  }
+  Poll();
+}
+
+file_watcher::~file_watcher() {
+  FindCloseChangeNotification(handle);
+}
+
+bool file_watcher::Poll() {
+  std::error_code ec;
+  const auto write = filesystem::last_write_time(file, ec);
+  if (ec) return false; // the file is being replaced
+  const auto size = filesystem::file_size(file, ec);
+  if (ec) return false;
+  if (write == lastWrite && size == lastSize) return false;
+  lastWrite = write;
+  lastSize = size;
+  return true;
+}
+
+void file_watcher::WaitForChange() {
+  for (;;) {
+    if (WaitForSingleObject(handle, INFINITE) != WAIT_OBJECT_0) {
+      throw std::runtime_error("Failed waiting for changes to " + file.u8string());
+    }
+    FindNextChangeNotification(handle);
+    if (!Poll()) continue; // something else in the folder changed
+
+    // The build may still be writing; wait until the folder has been quiet for a little while
+    while (WaitForSingleObject(handle, settleMilliseconds) == WAIT_OBJECT_0) {
+      FindNextChangeNotification(handle);
+      Poll();
+    }
+    return;
+  }
+}
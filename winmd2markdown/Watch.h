@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+
+/// <summary>
+/// Waits for a file to be rewritten (/watch). Listens for change notifications on the file's folder, then waits
+/// for the folder to go quiet so that a build that writes the file in several steps only triggers once.
+/// </summary>
+struct file_watcher
+{
+  file_watcher(std::filesystem::path watchedFile);
+  ~file_watcher();
+  file_watcher(const file_watcher&) = delete;
+  file_watcher& operator=(const file_watcher&) = delete;
+
+  /// Blocks until the file's size or timestamp changes and then stays put for settleMilliseconds.
+  void WaitForChange();
+
+  static constexpr uint32_t settleMilliseconds = 100;
+private:
+  bool Poll();
+
+  std::filesystem::path file;
+  void* handle; // change notification HANDLE
+  std::filesystem::file_time_type lastWrite{};
+  uintmax_t lastSize = 0;
+};
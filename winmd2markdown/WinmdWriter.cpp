@@ -0,0 +1,707 @@
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+#include "WinmdWriter.h"
+
+using namespace std;
+
+namespace {
+  // ECMA-335 II.22 table ids
+  namespace table {
+    enum : uint32_t {
+      Module = 0x00, TypeRef = 0x01, TypeDef = 0x02, Field = 0x04, MethodDef = 0x06, Param = 0x08,
+      InterfaceImpl = 0x09, MemberRef = 0x0a, Constant = 0x0b, CustomAttribute = 0x0c, EventMap = 0x12,
+      Event = 0x14, PropertyMap = 0x15, Property = 0x17, MethodSemantics = 0x18, TypeSpec = 0x1b,
+      Assembly = 0x20, AssemblyRef = 0x23,
+    };
+  }
+
+  // HasCustomAttribute tags
+  constexpr uint32_t hcaMethodDef = 0, hcaField = 1, hcaTypeDef = 3, hcaInterfaceImpl = 5, hcaProperty = 9, hcaEvent = 10;
+
+  void compress(string& out, uint32_t v) {
+    if (v < 0x80) {
+      out += static_cast<char>(v);
+    }
+    else if (v < 0x4000) {
+      out += static_cast<char>(0x80 | (v >> 8));
+      out += static_cast<char>(v & 0xff);
+    }
+    else {
+      out += static_cast<char>(0xc0 | (v >> 24));
+      out += static_cast<char>((v >> 16) & 0xff);
+      out += static_cast<char>((v >> 8) & 0xff);
+      out += static_cast<char>(v & 0xff);
+    }
+  }
+
+  void ser_string(string& out, string_view s) {
+    compress(out, static_cast<uint32_t>(s.size()));
+    out += s;
+  }
+
+  struct byte_writer {
+    string data;
+    void u8(uint8_t v) { data += static_cast<char>(v); }
+    void u16(uint16_t v) { u8(v & 0xff); u8(v >> 8); }
+    void u32(uint32_t v) { u16(v & 0xffff); u16(v >> 16); }
+    void u64(uint64_t v) { u32(v & 0xffffffff); u32(v >> 32); }
+    // writes a heap or table index that is either 2 or 4 bytes wide
+    void index(uint32_t v, uint32_t size) { if (size == 2) u16(static_cast<uint16_t>(v)); else u32(v); }
+    void bytes(string_view b) { data += b; }
+    void zeros(size_t n) { data.append(n, '\0'); }
+    void align(size_t a) { zeros((a - data.size() % a) % a); }
+    void pad_to(size_t n) { zeros(n - data.size()); }
+  };
+
+  uint32_t index_size(size_t rows) {
+    return rows < 0x10000 ? 2 : 4;
+  }
+
+  uint32_t coded_size(uint32_t tagBits, initializer_list<size_t> rows) {
+    return max(rows) < (size_t(1) << (16 - tagBits)) ? 2 : 4;
+  }
+}
+
+WinmdWriter::Sig::Sig(const Type& t) {
+  bytes += static_cast<char>(t.isValueType ? 0x11 : 0x12);
+  compress(bytes, t.codedIndex);
+}
+
+WinmdWriter::Sig WinmdWriter::Sig::Generic(const Type& genericType, const std::vector<Sig>& args) {
+  Sig s(Element::Void);
+  s.bytes = static_cast<char>(0x15);
+  s.bytes += Sig(genericType).bytes;
+  compress(s.bytes, static_cast<uint32_t>(args.size()));
+  for (const auto& a : args) {
+    s.bytes += a.bytes;
+  }
+  return s;
+}
+
+WinmdWriter::WinmdWriter(std::string_view name) : assemblyName(name) {
+  // <Module> is always the first TypeDef
+  typeDefs.push_back({ 0, String("<Module>"), 0, 0, 1, 1 });
+
+  objectType = TypeRef("System", "Object");
+  enumType = TypeRef("System", "Enum");
+  valueType = TypeRef("System", "ValueType");
+  delegateType = TypeRef("System", "MulticastDelegate");
+  attributeType = TypeRef("System", "Attribute");
+  eventTokenType = TypeRef("Windows.Foundation", "EventRegistrationToken", true);
+
+  // Like MIDL does for doc_string/doc_default declared in the app's IDL, the attributes live in the winmd itself
+  for (const auto attr : { "DocStringAttribute", "DocDefaultAttribute" }) {
+    AddAttributeType(assemblyName, attr);
+    AddField("Content", Element::String);
+    AddConstructor();
+    (attr == string_view("DocStringAttribute") ? docStringCtor : docDefaultCtor) = (static_cast<uint32_t>(methods.size()) << 3) | 2;
+  }
+
+  // The DeprecationType argument is encoded as its underlying UInt32 so that the file can be read without Windows.winmd in the cache
+  string deprecatedSig{ '\x20', '\x03', static_cast<char>(Element::Void), static_cast<char>(Element::String), static_cast<char>(Element::U4), static_cast<char>(Element::U4) };
+  deprecatedCtor = AttributeCtor("Windows.Foundation.Metadata", "DeprecatedAttribute", deprecatedSig);
+  experimentalCtor = AttributeCtor("Windows.Foundation.Metadata", "ExperimentalAttribute", { '\x20', '\x00', static_cast<char>(Element::Void) });
+}
+
+uint32_t WinmdWriter::String(std::string_view s) {
+  if (s.empty()) return 0;
+  const auto [it, inserted] = stringIndex.try_emplace(string(s), static_cast<uint32_t>(strings.size()));
+  if (inserted) {
+    strings += s;
+    strings += '\0';
+  }
+  return it->second;
+}
+
+uint32_t WinmdWriter::Blob(std::string_view b) {
+  const auto [it, inserted] = blobIndex.try_emplace(string(b), static_cast<uint32_t>(blobs.size()));
+  if (inserted) {
+    compress(blobs, static_cast<uint32_t>(b.size()));
+    blobs += b;
+  }
+  return it->second;
+}
+
+WinmdWriter::Type WinmdWriter::TypeRef(std::string_view ns, std::string_view name, bool isValueType) {
+  const auto key = string(ns) + "." + string(name);
+  const auto [it, inserted] = typeRefIndex.try_emplace(key, static_cast<uint32_t>(typeRefs.size() + 1));
+  if (inserted) {
+    // ResolutionScope: AssemblyRef 1 is mscorlib, AssemblyRef 2 is Windows
+    const uint32_t assemblyRef = ns == "System" ? 1 : 2;
+    typeRefs.push_back({ (assemblyRef << 2) | 2, String(name), String(ns) });
+  }
+  return { (it->second << 2) | 1, isValueType };
+}
+
+WinmdWriter::Type WinmdWriter::TypeSpec(const Sig& signature) {
+  const auto [it, inserted] = typeSpecIndex.try_emplace(signature.bytes, static_cast<uint32_t>(typeSpecs.size() + 1));
+  if (inserted) {
+    typeSpecs.push_back(signature.bytes);
+  }
+  return { (it->second << 2) | 2, false };
+}
+
+WinmdWriter::Entity WinmdWriter::AddType(uint32_t flags, std::string_view ns, std::string_view name, uint32_t extends) {
+  typeDefs.push_back({ flags, String(name), String(ns), extends, static_cast<uint32_t>(fields.size() + 1), static_cast<uint32_t>(methods.size() + 1) });
+  currentIsInterface = (flags & 0x20) != 0;
+  currentIsValueType = extends == valueType.codedIndex || extends == enumType.codedIndex;
+  return { (static_cast<uint32_t>(typeDefs.size()) << 5) | hcaTypeDef };
+}
+
+// TypeAttributes: Public 0x1, SequentialLayout 0x8, Interface 0x20, Abstract 0x80, Sealed 0x100, WindowsRuntime 0x4000
+WinmdWriter::Entity WinmdWriter::AddClass(std::string_view ns, std::string_view name) {
+  return AddType(0x4101, ns, name, objectType.codedIndex);
+}
+
+WinmdWriter::Entity WinmdWriter::AddInterface(std::string_view ns, std::string_view name) {
+  return AddType(0x40a1, ns, name, 0);
+}
+
+WinmdWriter::Entity WinmdWriter::AddEnum(std::string_view ns, std::string_view name) {
+  auto e = AddType(0x4101, ns, name, enumType.codedIndex);
+  fields.push_back({ 0x0601, String("value__"), Blob(string{ '\x06' } + Sig(Element::I4).bytes) });
+  return e;
+}
+
+WinmdWriter::Entity WinmdWriter::AddStruct(std::string_view ns, std::string_view name) {
+  return AddType(0x4109, ns, name, valueType.codedIndex);
+}
+
+WinmdWriter::Entity WinmdWriter::AddDelegate(std::string_view ns, std::string_view name, const Sig& returnType, const std::vector<Param>& params) {
+  auto d = AddType(0x4101, ns, name, delegateType.codedIndex);
+  string ctorSig{ '\x20', '\x02', static_cast<char>(Element::Void), static_cast<char>(Element::Object), static_cast<char>(Element::I) };
+  AddMethodRow(0x1881, 0x0003, ".ctor", ctorSig, { { "object", Element::Object }, { "method", Element::I } });
+  AddMethod("Invoke", returnType, params);
+  methods.back().flags |= 0x0800; // SpecialName
+  return d;
+}
+
+WinmdWriter::Entity WinmdWriter::AddAttributeType(std::string_view ns, std::string_view name) {
+  return AddType(0x4101, ns, name, attributeType.codedIndex);
+}
+
+WinmdWriter::Type WinmdWriter::CurrentType() const {
+  return { (static_cast<uint32_t>(typeDefs.size()) << 2), currentIsValueType };
+}
+
+uint32_t WinmdWriter::AddMethodRow(uint16_t flags, uint16_t implFlags, std::string_view name, const std::string& signature, const std::vector<Param>& methodParams) {
+  methods.push_back({ implFlags, flags, String(name), Blob(signature), static_cast<uint32_t>(params.size() + 1) });
+  uint16_t sequence = 1;
+  for (const auto& p : methodParams) {
+    params.push_back({ static_cast<uint16_t>(p.byRef ? 0x2 : 0x1), sequence++, String(p.name) });
+  }
+  return static_cast<uint32_t>(methods.size());
+}
+
+namespace {
+  string method_sig(bool isStatic, const WinmdWriter::Sig& returnType, const std::vector<WinmdWriter::Param>& params) {
+    string sig(1, isStatic ? '\x00' : '\x20');
+    compress(sig, static_cast<uint32_t>(params.size()));
+    sig += returnType.bytes;
+    for (const auto& p : params) {
+      if (p.byRef) sig += '\x10';
+      sig += p.type.bytes;
+    }
+    return sig;
+  }
+}
+
+// MethodAttributes: Public 0x6, Static 0x10, Final 0x20, Virtual 0x40, HideBySig 0x80, NewSlot 0x100, Abstract 0x400,
+// SpecialName 0x800, RTSpecialName 0x1000. MethodImplAttributes: Runtime 0x3
+WinmdWriter::Entity WinmdWriter::AddConstructor(const std::vector<Param>& ctorParams) {
+  const auto row = AddMethodRow(0x1886, 0x0003, ".ctor", method_sig(false, Element::Void, ctorParams), ctorParams);
+  return { (row << 5) | hcaMethodDef };
+}
+
+WinmdWriter::Entity WinmdWriter::AddMethod(std::string_view name, const Sig& returnType, const std::vector<Param>& methodParams, bool isStatic) {
+  const uint16_t flags = isStatic ? 0x0096 : (currentIsInterface ? 0x05c6 : 0x01e6);
+  const uint16_t implFlags = currentIsInterface ? 0 : 0x0003;
+  const auto row = AddMethodRow(flags, implFlags, name, method_sig(isStatic, returnType, methodParams), methodParams);
+  return { (row << 5) | hcaMethodDef };
+}
+
+WinmdWriter::Entity WinmdWriter::AddProperty(std::string_view name, const Sig& type, bool readonly, bool isStatic) {
+  const auto owner = static_cast<uint32_t>(typeDefs.size());
+  if (propertyMap.empty() || propertyMap.back().parent != owner) {
+    propertyMap.push_back({ owner, static_cast<uint32_t>(properties.size() + 1) });
+  }
+  string sig(1, isStatic ? '\x08' : '\x28');
+  sig += '\x00';
+  sig += type.bytes;
+  properties.push_back({ 0, String(name), Blob(sig) });
+  const auto prop = static_cast<uint32_t>(properties.size());
+
+  AddMethod("get_" + string(name), type, {}, isStatic);
+  methods.back().flags |= 0x0800;
+  methodSemantics.push_back({ 0x0002, static_cast<uint32_t>(methods.size()), (prop << 1) | 1 });
+  if (!readonly) {
+    AddMethod("put_" + string(name), Element::Void, { { "value", type } }, isStatic);
+    methods.back().flags |= 0x0800;
+    methodSemantics.push_back({ 0x0001, static_cast<uint32_t>(methods.size()), (prop << 1) | 1 });
+  }
+  return { (prop << 5) | hcaProperty };
+}
+
+WinmdWriter::Entity WinmdWriter::AddEvent(std::string_view name, const Type& handlerType) {
+  const auto owner = static_cast<uint32_t>(typeDefs.size());
+  if (eventMap.empty() || eventMap.back().parent != owner) {
+    eventMap.push_back({ owner, static_cast<uint32_t>(events.size() + 1) });
+  }
+  events.push_back({ 0, String(name), handlerType.codedIndex });
+  const auto evt = static_cast<uint32_t>(events.size());
+
+  Sig handler(Element::Void);
+  if ((handlerType.codedIndex & 3) == 2) {
+    handler.bytes = typeSpecs[(handlerType.codedIndex >> 2) - 1];
+  }
+  else {
+    handler = Sig(handlerType);
+  }
+  AddMethod("add_" + string(name), eventTokenType, { { "handler", handler } });
+  methods.back().flags |= 0x0800;
+  methodSemantics.push_back({ 0x0008, static_cast<uint32_t>(methods.size()), evt << 1 });
+  AddMethod("remove_" + string(name), Element::Void, { { "token", eventTokenType } });
+  methods.back().flags |= 0x0800;
+  methodSemantics.push_back({ 0x0010, static_cast<uint32_t>(methods.size()), evt << 1 });
+  return { (evt << 5) | hcaEvent };
+}
+
+WinmdWriter::Entity WinmdWriter::AddField(std::string_view name, const Sig& type) {
+  fields.push_back({ 0x0006, String(name), Blob(string{ '\x06' } + type.bytes) });
+  return { (static_cast<uint32_t>(fields.size()) << 5) | hcaField };
+}
+
+WinmdWriter::Entity WinmdWriter::AddEnumValue(std::string_view name, int32_t value) {
+  // Public | Static | Literal | HasDefault
+  fields.push_back({ 0x8056, String(name), Blob(string{ '\x06' } + Sig(CurrentType()).bytes) });
+  const auto row = static_cast<uint32_t>(fields.size());
+  byte_writer v;
+  v.u32(static_cast<uint32_t>(value));
+  constants.push_back({ static_cast<uint8_t>(Element::I4), row << 2, Blob(v.data) });
+  return { (row << 5) | hcaField };
+}
+
+WinmdWriter::Entity WinmdWriter::AddInterfaceImpl(const Type& iface) {
+  interfaceImpls.push_back({ static_cast<uint32_t>(typeDefs.size()), iface.codedIndex });
+  return { (static_cast<uint32_t>(interfaceImpls.size()) << 5) | hcaInterfaceImpl };
+}
+
+uint32_t WinmdWriter::AttributeCtor(std::string_view ns, std::string_view name, const std::string& signature) {
+  const auto type = TypeRef(ns, name);
+  // MemberRefParent tag 1 is TypeRef
+  memberRefs.push_back({ ((type.codedIndex >> 2) << 3) | 1, String(".ctor"), Blob(signature) });
+  // CustomAttributeType tag 3 is MemberRef
+  return (static_cast<uint32_t>(memberRefs.size()) << 3) | 3;
+}
+
+void WinmdWriter::AddAttribute(const Entity& target, uint32_t ctor, const std::string& value) {
+  customAttributes.push_back({ target.codedIndex, ctor, Blob(value) });
+}
+
+void WinmdWriter::AddContentAttribute(const Entity& target, uint32_t ctor, std::string_view content) {
+  string value{ '\x01', '\x00', '\x01', '\x00', '\x53', static_cast<char>(Element::String) };
+  ser_string(value, "Content");
+  ser_string(value, content);
+  AddAttribute(target, ctor, value);
+}
+
+void WinmdWriter::DocString(const Entity& target, std::string_view content) {
+  AddContentAttribute(target, docStringCtor, content);
+}
+
+void WinmdWriter::DocDefault(const Entity& target, std::string_view content) {
+  AddContentAttribute(target, docDefaultCtor, content);
+}
+
+void WinmdWriter::Deprecated(const Entity& target, std::string_view message) {
+  string value{ '\x01', '\x00' };
+  ser_string(value, message);
+  byte_writer args;
+  args.u32(0); // DeprecationType.Deprecate
+  args.u32(1); // version
+  args.u16(0); // no named args
+  AddAttribute(target, deprecatedCtor, value + args.data);
+}
+
+void WinmdWriter::Experimental(const Entity& target) {
+  AddAttribute(target, experimentalCtor, { '\x01', '\x00', '\x00', '\x00' });
+}
+
+void WinmdWriter::Save(const std::filesystem::path& path) const {
+  // Sorted tables are looked up by binary search in the reader
+  auto constants = this->constants;
+  stable_sort(constants.begin(), constants.end(), [](auto& a, auto& b) { return a.parent < b.parent; });
+  auto customAttributes = this->customAttributes;
+  stable_sort(customAttributes.begin(), customAttributes.end(), [](auto& a, auto& b) { return a.parent < b.parent; });
+  auto methodSemantics = this->methodSemantics;
+  stable_sort(methodSemantics.begin(), methodSemantics.end(), [](auto& a, auto& b) { return a.association < b.association; });
+
+  // Save is const, so the names and signatures that are only known now go to copies of the heaps
+  string stringHeap = strings;
+  string blobHeap = blobs;
+  auto heapString = [&](string_view s) {
+    const auto it = stringIndex.find(string(s));
+    if (it != stringIndex.end()) return it->second;
+    const auto offset = static_cast<uint32_t>(stringHeap.size());
+    stringHeap += s;
+    stringHeap += '\0';
+    return offset;
+  };
+  auto heapBlob = [&](string_view b) {
+    const auto it = blobIndex.find(string(b));
+    if (it != blobIndex.end()) return it->second;
+    const auto offset = static_cast<uint32_t>(blobHeap.size());
+    compress(blobHeap, static_cast<uint32_t>(b.size()));
+    blobHeap += b;
+    return offset;
+  };
+  vector<uint32_t> typeSpecBlobs;
+  typeSpecBlobs.reserve(typeSpecs.size());
+  for (const auto& s : typeSpecs) {
+    typeSpecBlobs.push_back(heapBlob(s));
+  }
+  const auto moduleName = heapString(assemblyName + ".winmd");
+  const auto assemblyNameIndex = heapString(assemblyName);
+  const auto mscorlibName = heapString("mscorlib");
+  const auto windowsName = heapString("Windows");
+  const auto mscorlibToken = heapBlob({ "\xb7\x7a\x5c\x56\x19\x34\xe0\x89", 8 });
+
+  constexpr size_t moduleRows = 1, assemblyRows = 1, assemblyRefRows = 2;
+  const uint32_t stringSize = stringHeap.size() < 0x10000 ? 2 : 4;
+  const uint32_t blobSize = blobHeap.size() < 0x10000 ? 2 : 4;
+  const uint32_t guidSize = 2;
+
+  const auto typeDefOrRef = coded_size(2, { typeDefs.size(), typeRefs.size(), typeSpecs.size() });
+  const auto hasConstant = coded_size(2, { fields.size(), params.size(), properties.size() });
+  const auto hasCustomAttribute = coded_size(5, { methods.size(), fields.size(), typeRefs.size(), typeDefs.size(), params.size(),
+    interfaceImpls.size(), memberRefs.size(), moduleRows, properties.size(), events.size(), typeSpecs.size(), assemblyRows, assemblyRefRows });
+  const auto hasSemantics = coded_size(1, { events.size(), properties.size() });
+  const auto memberRefParent = coded_size(3, { typeDefs.size(), typeRefs.size(), methods.size(), typeSpecs.size() });
+  const auto resolutionScope = coded_size(2, { moduleRows, typeRefs.size(), assemblyRefRows });
+  const auto customAttributeType = coded_size(3, { methods.size(), memberRefs.size() });
+
+  const pair<uint32_t, size_t> rowCounts[] = {
+    { table::Module, moduleRows }, { table::TypeRef, typeRefs.size() }, { table::TypeDef, typeDefs.size() },
+    { table::Field, fields.size() }, { table::MethodDef, methods.size() }, { table::Param, params.size() },
+    { table::InterfaceImpl, interfaceImpls.size() }, { table::MemberRef, memberRefs.size() },
+    { table::Constant, constants.size() }, { table::CustomAttribute, customAttributes.size() },
+    { table::EventMap, eventMap.size() }, { table::Event, events.size() }, { table::PropertyMap, propertyMap.size() },
+    { table::Property, properties.size() }, { table::MethodSemantics, methodSemantics.size() },
+    { table::TypeSpec, typeSpecs.size() }, { table::Assembly, assemblyRows }, { table::AssemblyRef, assemblyRefRows },
+  };
+
+  byte_writer t;
+  t.u32(0);
+  t.u8(2);
+  t.u8(0);
+  t.u8((stringSize == 4 ? 0x1 : 0) | (blobSize == 4 ? 0x4 : 0));
+  t.u8(1);
+  uint64_t valid = 0;
+  for (const auto& [id, rows] : rowCounts) {
+    if (rows) valid |= uint64_t(1) << id;
+  }
+  t.u64(valid);
+  t.u64(0x000016003301fa00); // sorted tables, as emitted by MIDL
+  for (const auto& [id, rows] : rowCounts) {
+    if (rows) t.u32(static_cast<uint32_t>(rows));
+  }
+
+  const auto fieldIdx = index_size(fields.size()), methodIdx = index_size(methods.size()), paramIdx = index_size(params.size());
+  const auto typeDefIdx = index_size(typeDefs.size()), eventIdx = index_size(events.size()), propertyIdx = index_size(properties.size());
+
+  // Module
+  t.u16(0);
+  t.index(moduleName, stringSize);
+  t.index(1, guidSize);
+  t.index(0, guidSize);
+  t.index(0, guidSize);
+  for (const auto& r : typeRefs) {
+    t.index(r.scope, resolutionScope);
+    t.index(r.name, stringSize);
+    t.index(r.ns, stringSize);
+  }
+  for (const auto& r : typeDefs) {
+    t.u32(r.flags);
+    t.index(r.name, stringSize);
+    t.index(r.ns, stringSize);
+    t.index(r.extends, typeDefOrRef);
+    t.index(r.fieldList, fieldIdx);
+    t.index(r.methodList, methodIdx);
+  }
+  for (const auto& r : fields) {
+    t.u16(r.flags);
+    t.index(r.name, stringSize);
+    t.index(r.signature, blobSize);
+  }
+  for (const auto& r : methods) {
+    t.u32(0); // RVA
+    t.u16(r.implFlags);
+    t.u16(r.flags);
+    t.index(r.name, stringSize);
+    t.index(r.signature, blobSize);
+    t.index(r.paramList, paramIdx);
+  }
+  for (const auto& r : params) {
+    t.u16(r.flags);
+    t.u16(r.sequence);
+    t.index(r.name, stringSize);
+  }
+  for (const auto& r : interfaceImpls) {
+    t.index(r.typeDef, typeDefIdx);
+    t.index(r.iface, typeDefOrRef);
+  }
+  for (const auto& r : memberRefs) {
+    t.index(r.parent, memberRefParent);
+    t.index(r.name, stringSize);
+    t.index(r.signature, blobSize);
+  }
+  for (const auto& r : constants) {
+    t.u8(r.type);
+    t.u8(0);
+    t.index(r.parent, hasConstant);
+    t.index(r.value, blobSize);
+  }
+  for (const auto& r : customAttributes) {
+    t.index(r.parent, hasCustomAttribute);
+    t.index(r.type, customAttributeType);
+    t.index(r.value, blobSize);
+  }
+  for (const auto& r : eventMap) {
+    t.index(r.parent, typeDefIdx);
+    t.index(r.list, eventIdx);
+  }
+  for (const auto& r : events) {
+    t.u16(r.flags);
+    t.index(r.name, stringSize);
+    t.index(r.type, typeDefOrRef);
+  }
+  for (const auto& r : propertyMap) {
+    t.index(r.parent, typeDefIdx);
+    t.index(r.list, propertyIdx);
+  }
+  for (const auto& r : properties) {
+    t.u16(r.flags);
+    t.index(r.name, stringSize);
+    t.index(r.type, blobSize);
+  }
+  for (const auto& r : methodSemantics) {
+    t.u16(r.semantics);
+    t.index(r.method, methodIdx);
+    t.index(r.association, hasSemantics);
+  }
+
+  for (const auto& s : typeSpecBlobs) {
+    t.index(s, blobSize);
+  }
+  // Assembly: HashAlgId, version 255.255.255.255, flags WindowsRuntime
+  t.u32(0x8004);
+  t.u16(0xffff); t.u16(0xffff); t.u16(0xffff); t.u16(0xffff);
+  t.u32(0x200);
+  t.index(0, blobSize);
+  t.index(assemblyNameIndex, stringSize);
+  t.index(0, stringSize);
+  // AssemblyRef 1: mscorlib, AssemblyRef 2: Windows
+  t.u16(4); t.u16(0); t.u16(0); t.u16(0);
+  t.u32(0);
+  t.index(mscorlibToken, blobSize);
+  t.index(mscorlibName, stringSize);
+  t.index(0, stringSize);
+  t.index(0, blobSize);
+  t.u16(0xffff); t.u16(0xffff); t.u16(0xffff); t.u16(0xffff);
+  t.u32(0x200);
+  t.index(0, blobSize);
+  t.index(windowsName, stringSize);
+  t.index(0, stringSize);
+  t.index(0, blobSize);
+  t.align(4);
+
+  stringHeap.append((4 - stringHeap.size() % 4) % 4, '\0');
+  blobHeap.append((4 - blobHeap.size() % 4) % 4, '\0');
+  const string userStrings(4, '\0');
+  const string guids("\x3c\x2d\x1a\x6e\x9b\x4f\x4d\x47\x8a\x5c\x37\x11\x52\x0e\x64\x90", 16);
+
+  // Metadata root (II.24.2.1) followed by the stream headers
+  constexpr string_view version = "WindowsRuntime 1.4";
+  const pair<string_view, const string*> streams[] = {
+    { "#~", &t.data }, { "#Strings", &stringHeap }, { "#US", &userStrings }, { "#GUID", &guids }, { "#Blob", &blobHeap },
+  };
+  const uint32_t versionLength = static_cast<uint32_t>((version.size() + 4) & ~3);
+  uint32_t headerSize = 16 + versionLength + 4;
+  for (const auto& s : streams) {
+    headerSize += 8 + static_cast<uint32_t>((s.first.size() + 4) & ~3);
+  }
+
+  byte_writer md;
+  md.u32(0x424a5342);
+  md.u16(1);
+  md.u16(1);
+  md.u32(0);
+  md.u32(versionLength);
+  md.bytes(version);
+  md.zeros(versionLength - version.size());
+  md.u16(0);
+  md.u16(static_cast<uint16_t>(size(streams)));
+  uint32_t streamOffset = headerSize;
+  for (const auto& s : streams) {
+    md.u32(streamOffset);
+    md.u32(static_cast<uint32_t>(s.second->size()));
+    md.bytes(s.first);
+    md.zeros(((s.first.size() + 4) & ~3) - s.first.size());
+    streamOffset += static_cast<uint32_t>(s.second->size());
+  }
+  for (const auto& s : streams) {
+    md.bytes(*s.second);
+  }
+
+  // PE32 image with a single section holding the CLI header and the metadata
+  constexpr uint32_t fileAlignment = 0x200, sectionAlignment = 0x2000, textRva = 0x2000, textOffset = 0x200, cliHeaderSize = 72;
+  const auto textSize = static_cast<uint32_t>(cliHeaderSize + md.data.size());
+  const auto rawSize = (textSize + fileAlignment - 1) & ~(fileAlignment - 1);
+  const auto imageSize = textRva + ((textSize + sectionAlignment - 1) & ~(sectionAlignment - 1));
+
+  byte_writer pe;
+  pe.data.reserve(textOffset + rawSize);
+  pe.u16(0x5a4d); // MZ
+  pe.pad_to(0x3c);
+  pe.u32(0x80); // e_lfanew
+  pe.pad_to(0x80);
+  pe.u32(0x00004550); // PE\0\0
+  pe.u16(0x14c); // i386
+  pe.u16(1); // NumberOfSections
+  pe.u32(0); pe.u32(0); pe.u32(0);
+  pe.u16(0xe0); // SizeOfOptionalHeader
+  pe.u16(0x2102); // EXECUTABLE_IMAGE | 32BIT_MACHINE | DLL
+  pe.u16(0x10b); // PE32
+  pe.u8(8); pe.u8(0);
+  pe.u32(rawSize); pe.u32(0); pe.u32(0); // SizeOfCode, SizeOfInitializedData, SizeOfUninitializedData
+  pe.u32(0); pe.u32(textRva); pe.u32(0); // AddressOfEntryPoint, BaseOfCode, BaseOfData
+  pe.u32(0x400000); pe.u32(sectionAlignment); pe.u32(fileAlignment);
+  pe.u16(4); pe.u16(0); pe.u16(0); pe.u16(0); pe.u16(4); pe.u16(0);
+  pe.u32(0); pe.u32(imageSize); pe.u32(textOffset); pe.u32(0);
+  pe.u16(3); // console subsystem
+  pe.u16(0x8540); // DYNAMIC_BASE | NX_COMPAT | NO_SEH | TERMINAL_SERVER_AWARE
+  pe.u32(0x100000); pe.u32(0x1000); pe.u32(0x100000); pe.u32(0x1000);
+  pe.u32(0); pe.u32(16);
+  for (uint32_t i = 0; i < 16; i++) {
+    pe.u32(i == 14 ? textRva : 0);
+    pe.u32(i == 14 ? cliHeaderSize : 0);
+  }
+  pe.bytes({ ".text\0\0\0", 8 });
+  pe.u32(textSize); pe.u32(textRva); pe.u32(rawSize); pe.u32(textOffset);
+  pe.u32(0); pe.u32(0); pe.u16(0); pe.u16(0);
+  pe.u32(0x60000020); // CODE | EXECUTE | READ
+  pe.pad_to(textOffset);
+
+  // CLI header (II.25.3.3)
+  pe.u32(cliHeaderSize);
+  pe.u16(2); pe.u16(5);
+  pe.u32(textRva + cliHeaderSize);
+  pe.u32(static_cast<uint32_t>(md.data.size()));
+  pe.u32(1); // COMIMAGE_FLAGS_ILONLY
+  pe.u32(0);
+  pe.zeros(cliHeaderSize - 24);
+  pe.bytes(md.data);
+  pe.pad_to(textOffset + rawSize);
+
+  std::ofstream out(path, ios::binary);
+  if (!out.good()) {
+    throw std::invalid_argument("Failed to create file " + path.u8string());
+  }
+  out.write(pe.data.data(), pe.data.size());
+}
+
+void WriteSyntheticCorpus(const std::filesystem::path& path, const corpus_options& opts) {
+  WinmdWriter w("Synthetic");
+  const auto vectorRef = w.TypeRef("Windows.Foundation.Collections", "IVector`1");
+  const auto eventHandlerRef = w.TypeRef("Windows.Foundation", "EventHandler`1");
+  const auto stringVector = w.TypeSpec(WinmdWriter::Sig::Generic(vectorRef, { WinmdWriter::Element::String }));
+  const auto objectHandler = w.TypeSpec(WinmdWriter::Sig::Generic(eventHandlerRef, { WinmdWriter::Element::Object }));
+  const WinmdWriter::Element primitives[] = {
+    WinmdWriter::Element::Boolean, WinmdWriter::Element::I4, WinmdWriter::Element::U8, WinmdWriter::Element::R8, WinmdWriter::Element::String,
+  };
+
+  for (size_t n = 0; n < opts.namespaces; n++) {
+    const auto ns = "Synthetic.Namespace" + to_string(n);
+    WinmdWriter::Type lastEnum, lastStruct, lastInterface, lastDelegate;
+    string lastInterfaceName;
+    for (size_t i = 0; i < opts.typesPerNamespace; i++) {
+      const auto typeName = "Type" + to_string(i);
+      auto doc = [&](const WinmdWriter::Entity& e, const string& text) {
+        if (opts.docStrings) w.DocString(e, text);
+      };
+      auto memberType = [&](size_t m) -> WinmdWriter::Sig {
+        if (m % 4 == 1 && lastEnum) return lastEnum;
+        if (m % 4 == 2 && lastStruct) return lastStruct;
+        return primitives[m % size(primitives)];
+      };
+
+      switch (i % 5) {
+      case 0: {
+        auto e = w.AddInterface(ns, "I" + typeName);
+        doc(e, "Interface number " + to_string(i) + ".\\nSee also @Type" + to_string(i + 1) + ".");
+        for (size_t m = 0; m < opts.membersPerType; m++) {
+          auto method = w.AddMethod("Method" + to_string(m), memberType(m), { { "value", memberType(m + 1) } });
+          doc(method, "Calls `Method" + to_string(m) + "` on the interface.");
+        }
+        lastInterface = w.CurrentType();
+        lastInterfaceName = "I" + typeName;
+        break;
+      }
+      case 1: {
+        auto e = w.AddClass(ns, typeName);
+        if (lastInterface) w.AddInterfaceImpl(lastInterface);
+        if (i % 10 == 1) w.AddInterfaceImpl(stringVector);
+        doc(e, "Class number " + to_string(i) + " implements @" + lastInterfaceName + ".");
+        if (i % 11 == 1) w.Experimental(e);
+        w.AddConstructor();
+        for (size_t m = 0; m < opts.membersPerType; m++) {
+          WinmdWriter::Entity member;
+          switch (m % 3) {
+          case 0:
+            member = w.AddProperty("Property" + to_string(m), memberType(m), m % 2 == 0);
+            if (opts.docStrings) w.DocDefault(member, to_string(m));
+            break;
+          case 1:
+            member = w.AddMethod("Method" + to_string(m), memberType(m), { { "a", memberType(m + 1) }, { "b", memberType(m + 2), true } }, m % 7 == 1);
+            break;
+          default:
+            member = w.AddEvent("Event" + to_string(m), lastDelegate ? lastDelegate : objectHandler);
+            break;
+          }
+          doc(member, "Member " + to_string(m) + " of @" + typeName + ". Uses @.Property0 and @" + ns + "." + typeName + ".");
+          if (m % 7 == 3) w.Deprecated(member, "Use @.Method1 instead");
+          if (m % 13 == 5) w.Experimental(member);
+        }
+        break;
+      }
+      case 2: {
+        auto e = w.AddEnum(ns, typeName);
+        doc(e, "Enum number " + to_string(i) + ".");
+        for (size_t m = 0; m < opts.membersPerType; m++) {
+          doc(w.AddEnumValue("Value" + to_string(m), static_cast<int32_t>(m)), "Value " + to_string(m) + ".\\r\\nSecond line.");
+        }
+        lastEnum = w.CurrentType();
+        break;
+      }
+      case 3: {
+        auto e = w.AddStruct(ns, typeName);
+        doc(e, "Struct number " + to_string(i) + ".");
+        for (size_t m = 0; m < opts.membersPerType; m++) {
+          doc(w.AddField("Field" + to_string(m), m % 4 == 1 && lastEnum ? WinmdWriter::Sig(lastEnum) : WinmdWriter::Sig(primitives[m % size(primitives)])), "Field " + to_string(m) + ".");
+        }
+        lastStruct = w.CurrentType();
+        break;
+      }
+      default: {
+        auto e = w.AddDelegate(ns, typeName, WinmdWriter::Element::Void, { { "sender", WinmdWriter::Element::Object }, { "args", memberType(i) } });
+        doc(e, "Delegate number " + to_string(i) + ".");
+        lastDelegate = w.CurrentType();
+        break;
+      }
+      }
+    }
+  }
+  w.Save(path);
+}
@@ -0,0 +1,167 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Minimal ECMA-335 metadata writer used to produce synthetic .winmd files for tests and benchmarks.
+/// It only emits the tables that winmd2md reads (TypeDef, MethodDef, Param, Property, Event, Field, InterfaceImpl,
+/// TypeSpec, MemberRef, CustomAttribute, Constant and their maps), so inputs can be created without MIDL.
+/// Members must be added to the most recently added type, which is how the Field/MethodDef/Property/Event
+/// lists are laid out in the file.
+/// </summary>
+struct WinmdWriter
+{
+  enum class Element : uint8_t
+  {
+    Void = 0x01,
+    Boolean = 0x02,
+    Char = 0x03,
+    I1 = 0x04,
+    U1 = 0x05,
+    I2 = 0x06,
+    U2 = 0x07,
+    I4 = 0x08,
+    U4 = 0x09,
+    I8 = 0x0a,
+    U8 = 0x0b,
+    R4 = 0x0c,
+    R8 = 0x0d,
+    String = 0x0e,
+    I = 0x18,
+    Object = 0x1c,
+  };
+
+  /// A TypeDef, TypeRef or TypeSpec, encoded the way TypeDefOrRef coded indices are.
+  struct Type
+  {
+    uint32_t codedIndex{ 0 };
+    bool isValueType{ false };
+    explicit operator bool() const { return codedIndex != 0; }
+  };
+
+  /// An entity that custom attributes can be applied to (HasCustomAttribute coded index).
+  struct Entity
+  {
+    uint32_t codedIndex{ 0 };
+  };
+
+  /// An encoded type signature, e.g. Sig(Element::I4) or Sig(someType).
+  struct Sig
+  {
+    std::string bytes;
+    Sig(Element e) : bytes(1, static_cast<char>(e)) {}
+    Sig(const Type& t);
+    static Sig Generic(const Type& genericType, const std::vector<Sig>& args);
+  };
+
+  struct Param
+  {
+    std::string name;
+    Sig type;
+    bool byRef{ false };
+  };
+
+  WinmdWriter(std::string_view assemblyName);
+
+  Type TypeRef(std::string_view ns, std::string_view name, bool isValueType = false);
+  /// Adds (or reuses) a TypeSpec row, e.g. for a generic instantiation built with Sig::Generic.
+  Type TypeSpec(const Sig& signature);
+
+  Entity AddClass(std::string_view ns, std::string_view name);
+  Entity AddInterface(std::string_view ns, std::string_view name);
+  Entity AddEnum(std::string_view ns, std::string_view name);
+  Entity AddStruct(std::string_view ns, std::string_view name);
+  Entity AddDelegate(std::string_view ns, std::string_view name, const Sig& returnType, const std::vector<Param>& params);
+  Entity AddAttributeType(std::string_view ns, std::string_view name);
+
+  /// The type most recently added with one of the Add* type functions.
+  Type CurrentType() const;
+
+  Entity AddConstructor(const std::vector<Param>& params = {});
+  Entity AddMethod(std::string_view name, const Sig& returnType, const std::vector<Param>& params = {}, bool isStatic = false);
+  Entity AddProperty(std::string_view name, const Sig& type, bool readonly = false, bool isStatic = false);
+  Entity AddEvent(std::string_view name, const Type& handlerType);
+  Entity AddField(std::string_view name, const Sig& type);
+  Entity AddEnumValue(std::string_view name, int32_t value);
+  Entity AddInterfaceImpl(const Type& iface);
+
+  void DocString(const Entity& target, std::string_view content);
+  void DocDefault(const Entity& target, std::string_view content);
+  void Deprecated(const Entity& target, std::string_view message);
+  void Experimental(const Entity& target);
+
+  void Save(const std::filesystem::path& path) const;
+
+private:
+  struct TypeDefRow { uint32_t flags; uint32_t name; uint32_t ns; uint32_t extends; uint32_t fieldList; uint32_t methodList; };
+  struct TypeRefRow { uint32_t scope; uint32_t name; uint32_t ns; };
+  struct FieldRow { uint16_t flags; uint32_t name; uint32_t signature; };
+  struct MethodDefRow { uint16_t implFlags; uint16_t flags; uint32_t name; uint32_t signature; uint32_t paramList; };
+  struct ParamRow { uint16_t flags; uint16_t sequence; uint32_t name; };
+  struct InterfaceImplRow { uint32_t typeDef; uint32_t iface; };
+  struct MemberRefRow { uint32_t parent; uint32_t name; uint32_t signature; };
+  struct ConstantRow { uint8_t type; uint32_t parent; uint32_t value; };
+  struct CustomAttributeRow { uint32_t parent; uint32_t type; uint32_t value; };
+  struct MapRow { uint32_t parent; uint32_t list; };
+  struct EventRow { uint16_t flags; uint32_t name; uint32_t type; };
+  struct PropertyRow { uint16_t flags; uint32_t name; uint32_t type; };
+  struct MethodSemanticsRow { uint16_t semantics; uint32_t method; uint32_t association; };
+
+  uint32_t String(std::string_view s);
+  uint32_t Blob(std::string_view b);
+  Entity AddType(uint32_t flags, std::string_view ns, std::string_view name, uint32_t extends);
+  uint32_t AddMethodRow(uint16_t flags, uint16_t implFlags, std::string_view name, const std::string& signature, const std::vector<Param>& params);
+  uint32_t AttributeCtor(std::string_view ns, std::string_view name, const std::string& signature);
+  void AddAttribute(const Entity& target, uint32_t ctor, const std::string& value);
+  void AddContentAttribute(const Entity& target, uint32_t ctor, std::string_view content);
+
+  std::string strings{ std::string(1, '\0') };
+  std::string blobs{ std::string(1, '\0') };
+  std::unordered_map<std::string, uint32_t> stringIndex;
+  std::unordered_map<std::string, uint32_t> blobIndex;
+
+  std::vector<TypeDefRow> typeDefs;
+  std::vector<TypeRefRow> typeRefs;
+  std::vector<FieldRow> fields;
+  std::vector<MethodDefRow> methods;
+  std::vector<ParamRow> params;
+  std::vector<InterfaceImplRow> interfaceImpls;
+  std::vector<MemberRefRow> memberRefs;
+  std::vector<ConstantRow> constants;
+  std::vector<CustomAttributeRow> customAttributes;
+  std::vector<MapRow> eventMap;
+  std::vector<EventRow> events;
+  std::vector<MapRow> propertyMap;
+  std::vector<PropertyRow> properties;
+  std::vector<MethodSemanticsRow> methodSemantics;
+  std::vector<std::string> typeSpecs;
+  std::unordered_map<std::string, uint32_t> typeRefIndex;
+  std::unordered_map<std::string, uint32_t> typeSpecIndex;
+
+  std::string assemblyName;
+  Type objectType, enumType, valueType, delegateType, attributeType, eventTokenType;
+  uint32_t docStringCtor{ 0 };
+  uint32_t docDefaultCtor{ 0 };
+  uint32_t deprecatedCtor{ 0 };
+  uint32_t experimentalCtor{ 0 };
+  bool currentIsInterface{ false };
+  bool currentIsValueType{ false };
+};
+
+struct corpus_options
+{
+  size_t namespaces{ 1 };
+  size_t typesPerNamespace{ 100 };
+  size_t membersPerType{ 10 };
+  bool docStrings{ true };
+};
+
+/// <summary>
+/// Writes a synthetic winmd with a deterministic mix of classes, interfaces, enums, structs and delegates,
+/// cross-referencing each other and carrying doc_string/doc_default/deprecated/experimental attributes.
+/// </summary>
+void WriteSyntheticCorpus(const std::filesystem::path& path, const corpus_options& opts);
@@ -0,0 +1,123 @@
+#include <fstream>
+#include <stdexcept>
+
+#include "XrefMap.h"
+
+using namespace std;
+
+namespace {
+  string_view Trim(string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) text.remove_suffix(1);
+    return text;
+  }
+
+  /// The value of a "key: value" line, without the quotes YAML may put around it
+  string_view Value(string_view line, string_view key) {
+    if (line.substr(0, key.length()) != key || line.substr(key.length(), 1) != ":") return {};
+    auto value = Trim(line.substr(key.length() + 1));
+    if (value.length() >= 2 && (value.front() == '"' || value.front() == '\'') && value.back() == value.front()) {
+      value = value.substr(1, value.length() - 2);
+    }
+    return value;
+  }
+}
+
+uint64_t xref_map::Hash(string_view uid) {
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (const auto c : uid) {
+    h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+  }
+  return h;
+}
+
+uint64_t xref_map::ContentHash() const {
+  uint64_t h = Hash(arena);
+  for (const auto& e : entries) {
+    h = (h ^ e.uidLength) * 0x100000001b3ull;
+    h = (h ^ e.urlLength) * 0x100000001b3ull;
+  }
+  return h;
+}
+
+void xref_map::Load(const filesystem::path& file) {
+  ifstream in(file, ios::binary);
+  if (!in) {
+    throw runtime_error("Can't read the xref map " + file.u8string());
+  }
+  string baseUrl;
+  string uid;
+  string href;
+  auto add = [&]() {
+    if (!uid.empty() && !href.empty()) {
+      // hrefs are relative to baseUrl unless they're absolute
+      Add(uid, href.find(':') == string::npos && href.front() != '/' ? baseUrl + href : href);
+    }
+    uid.clear();
+    href.clear();
+  };
+  string line;
+  while (getline(in, line)) {
+    auto trimmed = Trim(line);
+    if (trimmed.empty() || trimmed.front() == '#') continue;
+
+    if (const auto tab = trimmed.find('\t'); tab != string_view::npos && trimmed.front() != '-') {
+      Add(Trim(trimmed.substr(0, tab)), Trim(trimmed.substr(tab + 1)));
+      continue;
+    }
+    if (trimmed.substr(0, 2) == "- ") {
+      // the next reference; its keys can come in any order
+      add();
+      trimmed = Trim(trimmed.substr(2));
+    }
+    if (const auto value = Value(trimmed, "uid"); !value.empty()) {
+      uid = string(value);
+    }
+    else if (const auto value = Value(trimmed, "href"); !value.empty()) {
+      href = string(value);
+    }
+    else if (const auto value = Value(trimmed, "baseUrl"); !value.empty()) {
+      baseUrl = string(value);
+    }
+  }
+  add();
+}
+
+void xref_map::Add(string_view uid, string_view url) {
+  if (uid.empty() || url.empty() || !Find(uid).empty()) return;
+  if ((entries.size() + 1) * 2 > slots.size()) {
+    Grow();
+  }
+  const entry e{ Hash(uid), static_cast<uint32_t>(arena.length()), static_cast<uint32_t>(uid.length()),
+    static_cast<uint32_t>(arena.length() + uid.length()), static_cast<uint32_t>(url.length()) };
+  arena.append(uid);
+  arena.append(url);
+  const auto mask = slots.size() - 1;
+  auto slot = e.hash & mask;
+  while (slots[slot] != emptySlot) slot = (slot + 1) & mask;
+  slots[slot] = static_cast<uint32_t>(entries.size());
+  entries.push_back(e);
+}
+
+string_view xref_map::Find(string_view uid) const {
+  if (slots.empty()) return {};
+  const auto hash = Hash(uid);
+  const auto mask = slots.size() - 1;
+  for (auto slot = hash & mask; slots[slot] != emptySlot; slot = (slot + 1) & mask) {
+    const auto& e = entries[slots[slot]];
+    if (e.hash == hash && Uid(e) == uid) {
+      return string_view(arena).substr(e.url, e.urlLength);
+    }
+  }
+  return {};
+}
+
+void xref_map::Grow() {
+  slots.assign(slots.empty() ? 1024 : slots.size() * 2, emptySlot);
+  const auto mask = slots.size() - 1;
+  for (uint32_t i = 0; i < entries.size(); i++) {
+    auto slot = entries[i].hash & mask;
+    while (slots[slot] != emptySlot) slot = (slot + 1) & mask;
+    slots[slot] = i;
+  }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// <summary>
+/// Where the docs of types from other WinMDs live (/xrefMap), loaded from DocFX xref maps (xrefmap.yml: a list of
+/// uid/href pairs, with hrefs relative to baseUrl) or from text files with one uid, a tab and a URL per line.
+/// Entries go into one string arena and an open-addressing table of indices into it, so a map of a few hundred
+/// thousand uids costs a few allocations and a lookup is a hash and usually one comparison. When maps have the same
+/// uid, the one loaded first wins.
+/// </summary>
+struct xref_map
+{
+  /// Throws if the file can't be read.
+  void Load(const std::filesystem::path& file);
+  void Add(std::string_view uid, std::string_view url);
+  /// The URL for a uid, e.g. Contoso.Widgets.Widget or Contoso.Widgets.Widget.Resize*; empty when it's not mapped.
+  std::string_view Find(std::string_view uid) const;
+
+  size_t Size() const { return entries.size(); }
+  bool Empty() const { return entries.empty(); }
+  /// Changes whenever a uid or URL does, so output that depends on the maps can tell a rebuilt map from the same path.
+  uint64_t ContentHash() const;
+
+private:
+  struct entry {
+    uint64_t hash;
+    uint32_t uid;
+    uint32_t uidLength;
+    uint32_t url;
+    uint32_t urlLength;
+  };
+  static constexpr uint32_t emptySlot = UINT32_MAX;
+
+  static uint64_t Hash(std::string_view uid);
+  std::string_view Uid(const entry& e) const { return std::string_view(arena).substr(e.uid, e.uidLength); }
+  void Grow();
+
+  std::string arena;
+  std::vector<entry> entries;
+  /// Indices into entries; a power of two in size, at most half full
+  std::vector<uint32_t> slots;
+};
@@ -1,3 +1,4 @@
+#include <cstdio>
 #include <sstream>
 #include <boost/algorithm/string/replace.hpp>
 
@@ -7,26 +8,83 @@
 
 #include "output.h"
 #include "Format.h"
+#include "TextScan.h"
 
 using namespace std;
 
 output::output(Program* p) : program(p) {
 }
 
-filesystem::path output::GetFileForType(std::string_view name) {
-  std::filesystem::path out(program->opts->outputDirectory);
-  const string filename = std::string(name) + program->opts->fileSuffix + ".md";
-  if (!std::filesystem::exists(out)) {
+string output::GetPageDirectory(std::string_view name, std::string_view ns) const {
+  switch (layout) {
+  case page_layout::byNamespace:
+    return string(ns.empty() ? program->currentNamespace : ns);
+  case page_layout::byHash: {
+    char bucket[3];
+    snprintf(bucket, sizeof(bucket), "%02x", Crc32(name) & 0xff);
+    return bucket;
+  }
+  default:
+    return {};
+  }
+}
+
+filesystem::path output::GetFileForType(std::string_view name, std::string_view ns) {
+  const std::filesystem::path out(program->opts->outputDirectory);
+  // "index-" pages are the parts of a namespace's index (/indexPageSize); type names can't have a '-'
+  const auto directory = name == "index" || name._Starts_with("index-") ? GetIndexDirectory(ns.empty() ? program->currentNamespace : ns) : GetPageDirectory(name, ns);
+  if (!package && createdDirectories.find(directory) == createdDirectories.end()) {
+    // once per directory rather than checking for each page; the hash buckets are all made up front
     std::error_code ec;
-    std::filesystem::create_directory(out, ec); // ignore ec
+    std::filesystem::create_directories(out / directory, ec); // ignore ec
+    createdDirectories.insert(directory);
+    if (layout == page_layout::byHash) {
+      for (int i = 0; i < 256; i++) {
+        char bucket[3];
+        snprintf(bucket, sizeof(bucket), "%02x", i);
+        std::filesystem::create_directory(out / bucket, ec);
+        createdDirectories.insert(bucket);
+      }
+    }
   }
-  return out / filename;
+  return out / directory / (std::string(name) + program->opts->fileSuffix + ".md");
+}
+
+string output::GetLinkToType(std::string_view name, std::string_view fromDirectory, std::string_view ns) const {
+  const auto directory = GetPageDirectory(name, ns);
+  if (directory == fromDirectory) return string(name);
+  return (fromDirectory.empty() ? "" : "../") + directory + "/" + string(name);
 }
 
 output::type_helper output::StartType(std::string_view name, std::string_view kind) {
   EndType();
   indents = 0;
-  currentFile = std::move(GetOutputStream(GetFileForType(name)));
+  pageDirectory = GetPageDirectory(name);
+  if (redirect) {
+    currentFile = redirect;
+  }
+  else if (pageFilter && !pageFilter(program->currentNamespace, name)) {
+    currentFile = std::make_shared<std::ostream>(nullptr);
+  }
+  else {
+    const auto path = GetFileForType(name);
+    if (store) {
+      // the page may still be a link into the store from the last run; writing through it would change other versions
+      std::error_code ec;
+      std::filesystem::remove(path, ec);
+      store->Add(path);
+    }
+    if (siblings && !package) {
+      siblings->Add(path);
+    }
+    currentFile = (package || staged || html) ? OpenFile(path) : GetOutputStream(path);
+    if (snapshot || links) {
+      pageFile = std::move(currentFile);
+      page = std::make_shared<std::ostringstream>();
+      pageName = name;
+      currentFile = page;
+    }
+  }
   const auto apiVersionPrefix = (program->opts->apiVersion != "") ? ("version-" + program->opts->apiVersion + "-") : "";
   *currentFile << "---\n" <<
     "id: " << apiVersionPrefix << name << "\n" <<
@@ -38,9 +96,53 @@ output::type_helper output::StartType(std::string_view name, std::string_view ki
 
   *currentFile << "---\n\n";
   *currentFile << "Kind: " << code(kind) << "\n\n";
+  if (page) {
+    pageStart = static_cast<size_t>(page->tellp());
+  }
   return type_helper(*this);
 }
 
+void output::EndType() {
+  if (page) {
+    const auto text = page->str();
+    *pageFile << text;
+    const auto body = std::string_view(text).substr(pageStart);
+    if (snapshot) {
+      snapshot->SetPage(body);
+    }
+    if (links) {
+      links->AddPage(pageName, body);
+    }
+    currentFile = std::move(pageFile);
+    page.reset();
+  }
+  if (currentFile) {
+    currentFile->flush();
+  }
+  if (records) {
+    records->Flush();
+  }
+}
+
+void output::Record(const model_record& record) {
+  if (pageFilter && !pageFilter(record.ns, record.type)) return;
+  if (records) {
+    records->Write(record);
+  }
+  if (snapshot) {
+    snapshot->Add(record);
+  }
+  if (search) {
+    search->Add(record, GetLinkToType(record.type, "", record.ns));
+  }
+  if (model) {
+    model->Add(record);
+  }
+  if (state) {
+    state->Add(record);
+  }
+}
+
 output::section_helper output::StartSection(const std::string& a) {
   return section_helper(*this, a);
 }
@@ -56,36 +158,111 @@ output::section_helper::section_helper(output& out, string s) : o(out) {
 output::type_helper::type_helper(output& out) : o(out), sh(o.StartSection("")) {};
 
 void output::StartNamespace(std::string_view namespaceName) {
-  currentXml = intellisense_xml(namespaceName);
+  const auto xmlPath = std::filesystem::path(program->opts->outputDirectory) / (std::string(namespaceName) + ".xml");
+  currentXml = intellisense_xml(namespaceName, OpenFile(xmlPath));
+  if (snapshot) {
+    snapshot->StartNamespace(namespaceName);
+  }
+}
+
+void output::EndNamespace() {
+  currentXml.Close();
+  if (!redirect) {
+    currentFile.reset();
+  }
+  if (package) {
+    package->Flush();
+  }
+  if (staged) {
+    // the namespace's pages, index and intellisense file are complete once its back-references are in
+    staged->Commit();
+  }
+  if (html) {
+    html->Flush();
+  }
+  if (siblings) {
+    siblings->Flush();
+  }
+}
+
+std::shared_ptr<std::ostream> output::OpenFile(const std::filesystem::path& path, bool append) {
+  if (package) {
+    return package->Open(path.lexically_relative(program->opts->outputDirectory).generic_u8string(), append);
+  }
+  if (path.has_parent_path()) {
+    // the same directories GetFileForType keeps track of, so appending "Referenced by" doesn't check them again
+    const auto relative = path.parent_path().lexically_relative(program->opts->outputDirectory);
+    auto directory = relative.empty() ? path.parent_path().generic_u8string() : relative.generic_u8string();
+    if (directory == ".") directory.clear();
+    if (createdDirectories.insert(directory).second) {
+      std::error_code ec;
+      std::filesystem::create_directories(path.parent_path(), ec); // ignore ec
+    }
+  }
+  if (html && path.extension() == ".md") {
+    return html->Open(path, append);
+  }
+  if (staged) {
+    return staged->Open(path, append);
+  }
+  if (siblings) {
+    siblings->Add(path);
+  }
+  return std::make_shared<std::ofstream>(path, append ? std::ofstream::out | std::ofstream::app : std::ofstream::out);
+}
+
+output::discarded_pass::discarded_pass(output& out) : o(out), records(std::move(out.records)), snapshot(std::move(out.snapshot)), search(std::move(out.search)) {
+  o.Redirect(std::make_shared<std::ostream>(nullptr));
+}
+
+output::discarded_pass::~discarded_pass() {
+  o.Redirect(nullptr);
+  o.records = std::move(records);
+  o.snapshot = std::move(snapshot);
+  o.search = std::move(search);
+}
+
+void output::Redirect(std::shared_ptr<std::ostream> sink, int depth) {
+  redirect = sink;
+  currentFile = std::move(sink);
+  indents = depth;
 }
 
 
 void intellisense_xml::AddMember(MemberType mt, std::string shortName, std::string data) {
+  if (!out) return;
   auto parsedData = Sanitize(data);
-  out << R"(
+  *out << R"(
     <member name=")" << ToString(mt) << ":" << namespaceName << "." << shortName << R"(">
       <summary>)" << parsedData << R"(</summary>)";
 
-  out << R"(
+  *out << R"(
     </member>)";
 }
 
-bool isTag(size_t& pos, const std::string& text, const std::string tag) {
-  auto ret = text.substr(pos)._Starts_with(tag);
+bool isTag(size_t& pos, std::string_view text, std::string_view tag) {
+  auto ret = text.compare(pos, tag.length(), tag) == 0;
   if (ret) {
     pos += tag.length() - 1;
   }
   return ret;
 }
 
-std::string intellisense_xml::Sanitize(std::string text) {
+std::string intellisense_xml::Sanitize(std::string_view text) {
   bool isInCode = false;
   bool isInInlineCode = false;
-  stringstream ss;
+  string ss;
+  ss.reserve(text.length());
 
-  for (size_t input = 0; input < text.length(); input++) {
+  // Only < and ` can start markup, so the text in between is copied in bulk
+  size_t runStart = 0;
+  for (size_t input = FindFirstOf(text, 0, '<', '`'); input < text.length(); input = FindFirstOf(text, input + 1, '<', '`')) {
+    ss.append(text.data() + runStart, input - runStart);
+    runStart = input + 1;
     if (!isInCode && (isTag(input, text, "<br/>") || isTag(input, text, "<br />"))) {
-      ss << "\n"; break;
+      ss += "\n";
+      runStart = text.length();
+      break;
     }
     switch (text[input]) {
 
@@ -104,24 +281,25 @@ std::string intellisense_xml::Sanitize(std::string text) {
           }
         }
         isInCode = !isInCode;
-        if (!isInCode) {
+        if (!isInCode && !ss.empty()) {
           // remove the last newline
-          const size_t pos = ss.tellp();
-          ss.seekp(pos - 1);
+          ss.pop_back();
         }
-        ss << (isInCode ? "<example><code>" : "</code></example>");
+        ss += (isInCode ? "<example><code>" : "</code></example>");
       }
       else {
         isInInlineCode = !isInInlineCode;
-        ss << (isInInlineCode ? "<c>" : "</c>");
+        ss += (isInInlineCode ? "<c>" : "</c>");
       }
+      runStart = input + 1;
       break;
     }
     default:
-      ss << text[input]; break;
+      ss += text[input]; break;
     }
   }
+  ss.append(text.data() + runStart, text.length() - runStart);
   assert(!isInCode);
-  return ss.str();
+  return ss;
 }
 
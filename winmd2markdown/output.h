@@ -4,6 +4,23 @@
 #include <string_view>
 #include <iostream>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <set>
+#include <sstream>
+
+#include "ApiDiff.h"
+#include "Compression.h"
+#include "ContentStore.h"
+#include "Html.h"
+#include "Incremental.h"
+#include "LinkCheck.h"
+#include "NdJson.h"
+#include "Package.h"
+#include "SearchIndex.h"
+#include "StagedFiles.h"
+#include "TypeFilter.h"
+#include "Snapshot.h"
 
 struct Program;
 
@@ -18,14 +35,21 @@ enum class MemberType
 
 struct intellisense_xml
 {
-  std::ofstream out;
+  std::shared_ptr<std::ostream> out;
   intellisense_xml() = default;
   intellisense_xml(intellisense_xml&&) = default;
-  intellisense_xml& operator=(intellisense_xml&&) noexcept = default;
-  intellisense_xml(std::string_view _namespaceName)  : namespaceName(_namespaceName)
+  intellisense_xml& operator=(intellisense_xml&& other) noexcept {
+    Close();
+    out = std::move(other.out);
+    namespaceName = std::move(other.namespaceName);
+    isFragment = other.isFragment;
+    return *this;
+  }
+  // A fragment is just the <member> elements, without the document around them (/serve)
+  intellisense_xml(std::string_view _namespaceName, std::shared_ptr<std::ostream> file, bool fragment = false) : out(std::move(file)), namespaceName(_namespaceName), isFragment(fragment)
   {
-    out = std::ofstream("out\\" + namespaceName + ".xml");
-    out << R"(<?xml version="1.0" encoding="utf-8"?>
+    if (isFragment) return;
+    *out << R"(<?xml version="1.0" encoding="utf-8"?>
 <doc>
   <assembly>
     <name>)" << namespaceName << R"(</name>
@@ -35,17 +59,7 @@ struct intellisense_xml
 
   void AddMember(MemberType mt, std::string shortName, std::string data);
 
-  ~intellisense_xml() {
-    out << R"(
-  </members>
-</doc>)" << std::endl;
-  }
-
-private:
-  std::string namespaceName;
-
-  std::string Sanitize(std::string text);
-  char ToString(MemberType mt)
+  static char ToString(MemberType mt)
   {
     switch (mt)
     {
@@ -63,10 +77,39 @@ private:
       throw std::invalid_argument("unexpected member type");
     }
   }
+
+  ~intellisense_xml() {
+    Close();
+  }
+
+  void Close() {
+    if (out && !isFragment) {
+      *out << R"(
+  </members>
+</doc>)" << std::endl;
+    }
+    out.reset();
+  }
+
+private:
+  std::string namespaceName;
+  bool isFragment = false;
+
+  std::string Sanitize(std::string_view text);
 };
 
 std::shared_ptr<std::ostream> GetOutputStream(const std::filesystem::path& name);
 
+/// Where pages go under the output directory (/fanOut)
+enum class page_layout
+{
+  flat,
+  /// one directory per namespace, with the namespace's index
+  byNamespace,
+  /// 256 directories picked by a hash of the type name; the indexes stay at the top
+  byHash,
+};
+
 struct output
 {
 private:
@@ -84,17 +127,74 @@ public:
   friend output& operator<<(output& o, const T& t);
 
   void StartNamespace(std::string_view namespaceName);
-  std::filesystem::path GetFileForType(std::string_view typename);
+  /// Closes the namespace's intellisense file and, when writing a bundle or archive, flushes the namespace's files into it.
+  void EndNamespace();
+  /// Opens a file under the output directory, or its entry in the bundle or archive (/outputBundle, /outputArchive).
+  std::shared_ptr<std::ostream> OpenFile(const std::filesystem::path& path, bool append = false);
+  std::unique_ptr<package_writer> package;
+  std::unique_ptr<gzip_siblings> siblings;
+  /// Files held until their namespace is done, then written only if they changed (/atomicWrites)
+  std::unique_ptr<staged_files> staged;
+  /// Pages held until their namespace is done, then converted and written as HTML (/html)
+  std::unique_ptr<html_site> html;
+  /// Where the page bodies end up once the run is done (/contentStore)
+  std::unique_ptr<content_store> store;
+  /// Structured records for the types and members as they're rendered (/emit ndjson)
+  std::unique_ptr<ndjson_writer> records;
+  /// The model, pages and back-references, written out once the run is done (/outputSnapshot)
+  std::unique_ptr<snapshot_writer> snapshot;
+  /// Terms from the names and doc strings, written to search-index.json at the end (/searchIndex)
+  std::unique_ptr<search_index> search;
+  /// Every type's and member's API surface, to compare with another version's (/diffFrom)
+  std::unique_ptr<api_model> model;
+  /// What each page shows, to compare with the last run's (/incremental)
+  std::unique_ptr<incremental_state> state;
+  bool Modeling() const { return records || snapshot || search || model || state; }
+  /// When set, only the pages it accepts are written and the rest are rendered into a discarded stream (/incremental,
+  /// /namespace, /type). Only their records are passed on.
+  /// A namespace's index page is asked for as "index".
+  std::function<bool(std::string_view ns, std::string_view name)> pageFilter;
+  /// For as long as it's alive, renders into a discarded stream and keeps what's rendered from /emit, /outputSnapshot
+  /// and /searchIndex: the full pass that collects every type's back-references before only some pages are written.
+  struct discarded_pass {
+    output& o;
+    std::unique_ptr<ndjson_writer> records;
+    std::unique_ptr<snapshot_writer> snapshot;
+    std::unique_ptr<search_index> search;
+    discarded_pass(output& out);
+    ~discarded_pass();
+  };
+  /// Anchors and links of every page, checked at the end (/checkLinks)
+  std::unique_ptr<link_checker> links;
+  void Record(const model_record& record);
+  /// Renders into sink instead of the pages' files until called again with nullptr (/serve). depth is the heading level
+  /// the output starts at, for member fragments that would otherwise sit inside a type page.
+  void Redirect(std::shared_ptr<std::ostream> sink, int depth = 0);
+  page_layout layout = page_layout::flat;
+  /// The directory of a type's page relative to the output directory; ns defaults to the current namespace.
+  std::string GetPageDirectory(std::string_view name, std::string_view ns = {}) const;
+  std::string GetIndexDirectory(std::string_view ns) const { return layout == page_layout::byNamespace ? std::string(ns) : std::string(); }
+  std::filesystem::path GetFileForType(std::string_view typename, std::string_view ns = {});
+  /// The link to a type's page from the page being rendered, or from a file in fromDirectory.
+  std::string GetLinkToType(std::string_view name) const { return GetLinkToType(name, pageDirectory); }
+  std::string GetLinkToType(std::string_view name, std::string_view fromDirectory, std::string_view ns = {}) const;
+  /// Links as if from type name's page, for text added to the page after it was written (/mergeShards).
+  void LinkFrom(std::string_view name) { pageDirectory = GetPageDirectory(name); }
 private:
+  // directories under the output directory that are known to exist
+  std::set<std::string> createdDirectories;
+  std::string pageDirectory;
   int indents = 0;
+  std::shared_ptr<std::ostream> redirect;
+  // with /outputSnapshot or /checkLinks a page is rendered into memory first, then copied to its file and handed to them
+  std::shared_ptr<std::ostringstream> page;
+  std::string pageName;
+  std::shared_ptr<std::ostream> pageFile;
+  size_t pageStart = 0;
   void EndSection() {
     indents--;
   }
-  void EndType() {
-    if (currentFile) {
-      currentFile->flush();
-    }
-  }
+  void EndType();
   friend struct type_helper;
   struct section_helper {
     output& o;